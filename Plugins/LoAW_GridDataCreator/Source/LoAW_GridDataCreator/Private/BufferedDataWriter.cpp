@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BufferedDataWriter.h"
+
+#include <charconv>
+#include <HAL/PlatformFileManager.h>
+#include <Misc/Compression.h>
+
+FBufferedDataWriter::FBufferedDataWriter(int32 InBufferSize)
+	: BufferSize(FMath::Max(InBufferSize, 256))
+	, Capacity(BufferSize)
+{
+}
+
+FBufferedDataWriter::~FBufferedDataWriter()
+{
+	Close();
+}
+
+bool FBufferedDataWriter::Open(const FString& FullPath, bool bAppend, FName InCompressionFormat, int32 ChunkSize)
+{
+	Close();
+	bError = false;
+
+	bool bCanCompress = !bAppend && FChunkedDataFormat::FormatToIndex(InCompressionFormat) != 0;
+	CompressionFormat = bCanCompress ? InCompressionFormat : NAME_None;
+	ChunkCapacity = FMath::Max(ChunkSize, 256);
+	Capacity = IsCompressed() ? ChunkCapacity : BufferSize;
+	ChunkTable.Reset();
+	ChunkOffset = 0;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	FileHandle.Reset(PlatformFile.OpenWrite(*FullPath, bAppend, false));
+	if (!FileHandle) {
+		return false;
+	}
+
+	FileSize = bAppend ? FileHandle->Size() : 0;
+	Buffer.Reset(Capacity);
+	FlushBuffer.Reset(Capacity);
+	return true;
+}
+
+bool FBufferedDataWriter::Close()
+{
+	if (!FileHandle) {
+		return !bError;
+	}
+
+	FlushAsync();
+	WaitFlush();
+	if (IsCompressed()) {
+		WriteChunkTable();
+	}
+	if (!FileHandle->Flush()) {
+		bError = true;
+	}
+	FileHandle.Reset();
+	return !bError;
+}
+
+bool FBufferedDataWriter::Flush()
+{
+	if (!FileHandle) {
+		return !bError;
+	}
+
+	FlushAsync();
+	WaitFlush();
+	if (!FileHandle->Flush()) {
+		bError = true;
+	}
+	return !bError;
+}
+
+void FBufferedDataWriter::WriteRaw(const void* Data, int64 Size)
+{
+	const uint8* Ptr = static_cast<const uint8*>(Data);
+	while (Size > 0)
+	{
+		int32 Free = Capacity - Buffer.Num();
+		if (Free == 0) {
+			FlushAsync();
+			continue;
+		}
+		int32 Num = int32(FMath::Min<int64>(Size, Free));
+		Buffer.Append(Ptr, Num);
+		Ptr += Num;
+		Size -= Num;
+	}
+}
+
+void FBufferedDataWriter::WriteChar(char Value)
+{
+	Reserve(1);
+	Buffer.Add(uint8(Value));
+}
+
+void FBufferedDataWriter::WriteString(const FString& Str)
+{
+	FTCHARToUTF8 Converter(*Str);
+	WriteRaw(Converter.Get(), Converter.Length());
+}
+
+void FBufferedDataWriter::WriteInt(int64 Value)
+{
+	char Chars[24];
+	std::to_chars_result Result = std::to_chars(Chars, Chars + sizeof(Chars), Value);
+	WriteRaw(Chars, Result.ptr - Chars);
+}
+
+void FBufferedDataWriter::WriteFloat(double Value, int32 MaximumFractionalDigits)
+{
+	static constexpr int64 Pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+	int32 Digits = FMath::Clamp(MaximumFractionalDigits, 0, 8);
+	double Scaled = FMath::Abs(Value) * double(Pow10[Digits]);
+
+	//Out of fixed-point range, keep shortest round-trip text
+	if (!FMath::IsFinite(Scaled) || Scaled >= 9.0e18) {
+		char Chars[32];
+		std::to_chars_result Result = std::to_chars(Chars, Chars + sizeof(Chars), Value);
+		WriteRaw(Chars, Result.ptr - Chars);
+		return;
+	}
+
+	int64 Rounded = int64(Scaled + 0.5);
+	int64 Integral = Rounded / Pow10[Digits];
+	int64 Fraction = Rounded % Pow10[Digits];
+
+	char Chars[48];
+	char* Ptr = Chars;
+	if (Value < 0.0 && Rounded != 0) {
+		*Ptr++ = '-';
+	}
+	Ptr = std::to_chars(Ptr, Chars + sizeof(Chars), Integral).ptr;
+
+	if (Fraction != 0) {
+		*Ptr++ = '.';
+		for (int32 i = Digits - 1; i >= 0 && Fraction != 0; i--)
+		{
+			*Ptr++ = char('0' + Fraction / Pow10[i]);
+			Fraction %= Pow10[i];
+		}
+	}
+	WriteRaw(Chars, Ptr - Chars);
+}
+
+void FBufferedDataWriter::WriteLineEnd()
+{
+	WriteChar('\n');
+}
+
+void FBufferedDataWriter::Reserve(int32 Size)
+{
+	if (Buffer.Num() + Size > Capacity) {
+		FlushAsync();
+	}
+}
+
+void FBufferedDataWriter::FlushAsync()
+{
+	if (!FileHandle || Buffer.Num() == 0) {
+		return;
+	}
+
+	//Only one flush in flight, the handle is owned by the flush task until it completes
+	WaitFlush();
+	Swap(Buffer, FlushBuffer);
+	Buffer.Reset(Capacity);
+	FileSize += FlushBuffer.Num();
+
+	IFileHandle* Handle = FileHandle.Get();
+	TArray<uint8>* Data = &FlushBuffer;
+	FlushTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Handle, Data]()
+		{
+			if (IsCompressed()) {
+				WriteChunk(*Data);
+			}
+			else if (!Handle->Write(Data->GetData(), Data->Num())) {
+				bError = true;
+			}
+		});
+}
+
+void FBufferedDataWriter::WaitFlush()
+{
+	if (FlushTask.IsValid()) {
+		FlushTask.Wait();
+		FlushTask = UE::Tasks::FTask();
+	}
+}
+
+void FBufferedDataWriter::WriteChunk(const TArray<uint8>& Data)
+{
+	int32 CompressedSize = FCompression::CompressMemoryBound(CompressionFormat, Data.Num());
+	CompressBuffer.SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+
+	FChunkedDataEntry Entry;
+	Entry.Offset = ChunkOffset;
+	Entry.RawSize = Data.Num();
+
+	//Store raw when compression does not pay off
+	const uint8* ChunkData = Data.GetData();
+	Entry.CompressedSize = Data.Num();
+	if (FCompression::CompressMemory(CompressionFormat, CompressBuffer.GetData(), CompressedSize, Data.GetData(), Data.Num())
+		&& CompressedSize < Data.Num()) {
+		ChunkData = CompressBuffer.GetData();
+		Entry.CompressedSize = CompressedSize;
+	}
+
+	if (!FileHandle->Write(ChunkData, Entry.CompressedSize)) {
+		bError = true;
+	}
+	ChunkOffset += Entry.CompressedSize;
+	ChunkTable.Add(Entry);
+}
+
+void FBufferedDataWriter::WriteChunkTable()
+{
+	FChunkedDataFooter Footer;
+	Footer.TableOffset = ChunkOffset;
+	Footer.RawSize = FileSize;
+	Footer.ChunkNum = ChunkTable.Num();
+	Footer.ChunkSize = ChunkCapacity;
+	Footer.Format = FChunkedDataFormat::FormatToIndex(CompressionFormat);
+
+	if (!FileHandle->Write(reinterpret_cast<const uint8*>(ChunkTable.GetData()), ChunkTable.Num() * sizeof(FChunkedDataEntry))
+		|| !FileHandle->Write(reinterpret_cast<const uint8*>(&Footer), sizeof(FChunkedDataFooter))) {
+		bError = true;
+	}
+	ChunkTable.Reset();
+}
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ChunkedDataReader.h"
+
+#include <HAL/PlatformFileManager.h>
+#include <Misc/Compression.h>
+
+FChunkedDataReader::FChunkedDataReader(int32 InReadAheadNum)
+	: ReadAheadNum(FMath::Max(InReadAheadNum, 1))
+{
+}
+
+FChunkedDataReader::~FChunkedDataReader()
+{
+	Close();
+}
+
+bool FChunkedDataReader::Open(const FString& FullPath)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	FileHandle.Reset(PlatformFile.OpenRead(*FullPath));
+	if (!FileHandle) {
+		return false;
+	}
+
+	int64 FileSize = FileHandle->Size();
+	if (FileSize < int64(sizeof(FChunkedDataFooter))
+		|| !FileHandle->Seek(FileSize - sizeof(FChunkedDataFooter))
+		|| !FileHandle->Read(reinterpret_cast<uint8*>(&Footer), sizeof(FChunkedDataFooter))) {
+		Close();
+		return false;
+	}
+
+	CompressionFormat = FChunkedDataFormat::IndexToFormat(Footer.Format);
+	if (Footer.Magic != CHUNKED_DATA_MAGIC || Footer.Version != CHUNKED_DATA_VERSION
+		|| CompressionFormat.IsNone() || Footer.ChunkNum < 0 || Footer.ChunkSize <= 0
+		|| Footer.TableOffset + int64(Footer.ChunkNum) * sizeof(FChunkedDataEntry) + sizeof(FChunkedDataFooter) != FileSize) {
+		Close();
+		return false;
+	}
+
+	ChunkTable.SetNumUninitialized(Footer.ChunkNum);
+	if (!FileHandle->Seek(Footer.TableOffset)
+		|| !FileHandle->Read(reinterpret_cast<uint8*>(ChunkTable.GetData()), Footer.ChunkNum * sizeof(FChunkedDataEntry))) {
+		Close();
+		return false;
+	}
+
+	int64 RawSize = 0;
+	for (const FChunkedDataEntry& Entry : ChunkTable)
+	{
+		if (Entry.Offset < 0 || Entry.CompressedSize < 0 || Entry.Offset + Entry.CompressedSize > Footer.TableOffset
+			|| Entry.RawSize < 0 || Entry.RawSize > Footer.ChunkSize) {
+			Close();
+			return false;
+		}
+		RawSize += Entry.RawSize;
+	}
+	if (RawSize != Footer.RawSize) {
+		Close();
+		return false;
+	}
+
+	Slots.SetNum(ReadAheadNum);
+	for (int32 i = 0; i < ReadAheadNum && i < Footer.ChunkNum; i++)
+	{
+		LaunchChunk(i);
+	}
+	return true;
+}
+
+void FChunkedDataReader::Close()
+{
+	for (FChunkSlot& Slot : Slots)
+	{
+		if (Slot.Task.IsValid()) {
+			Slot.Task.Wait();
+		}
+	}
+	Slots.Empty();
+	ChunkTable.Empty();
+	FileHandle.Reset();
+	Footer = FChunkedDataFooter();
+	ConsumeIndex = -1;
+	ChunkPtr = nullptr;
+	ChunkRemain = 0;
+}
+
+bool FChunkedDataReader::Read(uint8* Dest, int64 Size)
+{
+	while (Size > 0)
+	{
+		if (ChunkRemain == 0 && !NextChunk()) {
+			return false;
+		}
+		int64 Num = FMath::Min(Size, ChunkRemain);
+		FMemory::Memcpy(Dest, ChunkPtr, Num);
+		Dest += Num;
+		Size -= Num;
+		ChunkPtr += Num;
+		ChunkRemain -= Num;
+	}
+	return true;
+}
+
+bool FChunkedDataReader::ReadFile(const FString& FullPath, TArray<uint8>& OutData)
+{
+	FChunkedDataReader Reader;
+	if (!Reader.Open(FullPath)) {
+		return false;
+	}
+	OutData.SetNumUninitialized(Reader.GetRawSize());
+	return Reader.Read(OutData.GetData(), OutData.Num());
+}
+
+void FChunkedDataReader::LaunchChunk(int32 ChunkIndex)
+{
+	FChunkSlot& Slot = Slots[ChunkIndex % ReadAheadNum];
+	const FChunkedDataEntry& Entry = ChunkTable[ChunkIndex];
+	Slot.Task = UE::Tasks::FTask();
+	Slot.Raw.SetNumUninitialized(Entry.RawSize, EAllowShrinking::No);
+
+	//Stored raw chunk, read straight into place
+	if (Entry.CompressedSize == Entry.RawSize) {
+		Slot.bSucceeded = FileHandle->Seek(Entry.Offset) && FileHandle->Read(Slot.Raw.GetData(), Entry.RawSize);
+		return;
+	}
+
+	Slot.Compressed.SetNumUninitialized(Entry.CompressedSize, EAllowShrinking::No);
+	if (!FileHandle->Seek(Entry.Offset) || !FileHandle->Read(Slot.Compressed.GetData(), Entry.CompressedSize)) {
+		Slot.bSucceeded = false;
+		return;
+	}
+
+	FName Format = CompressionFormat;
+	Slot.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Slot, Format]()
+		{
+			Slot.bSucceeded = FCompression::UncompressMemory(Format, Slot.Raw.GetData(), Slot.Raw.Num(),
+				Slot.Compressed.GetData(), Slot.Compressed.Num());
+		});
+}
+
+bool FChunkedDataReader::NextChunk()
+{
+	//Previous chunk is consumed, reuse its slot for the chunk read ahead
+	if (ConsumeIndex >= 0 && ConsumeIndex + ReadAheadNum < Footer.ChunkNum) {
+		LaunchChunk(ConsumeIndex + ReadAheadNum);
+	}
+
+	ConsumeIndex++;
+	if (ConsumeIndex >= Footer.ChunkNum) {
+		return false;
+	}
+
+	FChunkSlot& Slot = Slots[ConsumeIndex % ReadAheadNum];
+	if (Slot.Task.IsValid()) {
+		Slot.Task.Wait();
+	}
+	if (!Slot.bSucceeded) {
+		return false;
+	}
+
+	ChunkPtr = Slot.Raw.GetData();
+	ChunkRemain = Slot.Raw.Num();
+	return true;
+}
@@ -2,9 +2,11 @@
 
 
 #include "DataCreator.h"
+#include "ChunkedDataReader.h"
 
 #include <filesystem>
-#include <fstream>
+#include <HAL/PlatformFileManager.h>
+#include <Misc/FileHelper.h>
 
 DEFINE_LOG_CATEGORY(DataCreator);
 
@@ -30,19 +32,233 @@ bool ADataCreator::CreateFilePath(const FString& RelPath, FString& FullPath)
 	return false;
 }
 
-void ADataCreator::WritePipeDelimiter(std::ofstream& ofs)
+bool ADataCreator::OpenDataWriter(const FString& FullPath, bool bCompress, bool bAppend)
 {
-	ofs << TCHAR_TO_ANSI(*PipeDelim);
+	return OpenDataWriter(DataWriter, FullPath, bCompress, bAppend);
 }
 
-void ADataCreator::WriteColonDelimiter(std::ofstream& ofs)
+bool ADataCreator::OpenDataWriter(FBufferedDataWriter& Writer, const FString& FullPath, bool bCompress, bool bAppend)
 {
-	ofs << TCHAR_TO_ANSI(*ColonDelim);
+	FName Format = bCompress && bCompressData ? CompressionFormat : NAME_None;
+	return Writer.Open(FullPath, bAppend, Format, CompressionChunkSize);
 }
 
-void ADataCreator::WriteLineEnd(std::ofstream& ofs)
+TArray<FName> ADataCreator::GetCompressionFormatOptions() const
 {
-	ofs << std::endl;
+	return { NAME_Oodle, NAME_Zlib, NAME_Gzip, NAME_LZ4 };
+}
+
+void ADataCreator::WritePipeDelimiter(FBufferedDataWriter& Writer)
+{
+	Writer.WriteChar('|');
+}
+
+void ADataCreator::WriteCommaDelimiter(FBufferedDataWriter& Writer)
+{
+	Writer.WriteChar(',');
+}
+
+void ADataCreator::WriteSpaceDelimiter(FBufferedDataWriter& Writer)
+{
+	Writer.WriteChar(' ');
+}
+
+void ADataCreator::WriteColonDelimiter(FBufferedDataWriter& Writer)
+{
+	Writer.WriteChar(':');
+}
+
+void ADataCreator::WriteLineEnd(FBufferedDataWriter& Writer)
+{
+	Writer.WriteLineEnd();
+}
+
+void ADataCreator::WriteParamsHash(FBufferedDataWriter& Writer, uint32 Hash)
+{
+	Writer.WriteInt(Hash);
+	WriteLineEnd(Writer);
+}
+
+bool ADataCreator::ReadParamsHash(const FString& ParamsRelPath, uint32& Hash)
+{
+	TArray<FString> Params;
+	return ReadParams(ParamsRelPath, Params, Hash);
+}
+
+bool ADataCreator::IsDataUpToDate(const FString& ParamsRelPath, const TArray<FString>& DataRelPaths, uint32 Hash)
+{
+	uint32 SavedHash;
+	if (!ReadParamsHash(ParamsRelPath, SavedHash) || SavedHash != Hash) {
+		return false;
+	}
+
+	for (const FString& RelPath : DataRelPaths)
+	{
+		if (!FPaths::FileExists(FPaths::ProjectDir().Append(RelPath))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ADataCreator::ReadParams(const FString& ParamsRelPath, TArray<FString>& Params, uint32& Hash)
+{
+	TArray<FString> Lines;
+	FString FullPath = FPaths::ProjectDir().Append(ParamsRelPath);
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FullPath) || Lines.Num() < 2) {
+		return false;
+	}
+	Lines[0].TrimStartAndEnd().ParseIntoArray(Params, *PipeDelim, false);
+	return LexTryParseString(Hash, *Lines[1].TrimStartAndEnd());
+}
+
+bool ADataCreator::CanAppendDataFile(const FString& RelPath)
+{
+	//Chunked container can not be appended, neither can plain text when compression is on
+	FString FullPath = FPaths::ProjectDir().Append(RelPath);
+	if (bCompressData || !FPaths::FileExists(FullPath)) {
+		return false;
+	}
+	FChunkedDataReader Reader;
+	return !Reader.Open(FullPath);
+}
+
+void ADataCreator::InvalidateParams(const FString& ParamsRelPath)
+{
+	FString FullPath = FPaths::ProjectDir().Append(ParamsRelPath);
+	if (FPaths::FileExists(FullPath) && !IFileManager::Get().Delete(*FullPath)) {
+		UE_LOG(DataCreator, Warning, TEXT("Delete params file %s failed."), *FullPath);
+	}
+}
+
+bool ADataCreator::CanUseCheckpoint() const
+{
+	//Chunked container has its table at the end, a partial file can not be appended
+	return bUseCheckpoint && !bCompressData;
+}
+
+bool ADataCreator::IsCheckpointDue() const
+{
+	return CanUseCheckpoint() && FPlatformTime::Seconds() - LastCheckpointTime >= CheckpointInterval;
+}
+
+bool ADataCreator::SaveCheckpoint(const FString& CheckpointRelPath, const FDataCreatorCheckpoint& InCheckpoint)
+{
+	LastCheckpointTime = FPlatformTime::Seconds();
+
+	//Version|Hash|Stage|LoopCount, loop indices, values, then one RelPath|Size line per file
+	FString Content;
+	Content.Append(FString::FromInt(DATA_CREATOR_CHECKPOINT_VERSION)).Append(PipeDelim);
+	Content.Append(LexToString(InCheckpoint.ParamsHash)).Append(PipeDelim);
+	Content.Append(FString::FromInt(InCheckpoint.Stage)).Append(PipeDelim);
+	Content.Append(FString::FromInt(InCheckpoint.LoopCount)).Append(TEXT("\n"));
+	Content.Append(FString::JoinBy(InCheckpoint.LoopIndices, *CommaDelim, [](int32 Value) { return FString::FromInt(Value); })).Append(TEXT("\n"));
+	Content.Append(FString::JoinBy(InCheckpoint.Values, *CommaDelim, [](int32 Value) { return FString::FromInt(Value); })).Append(TEXT("\n"));
+	for (int32 i = 0; i < InCheckpoint.FileRelPaths.Num(); i++)
+	{
+		Content.Append(InCheckpoint.FileRelPaths[i]).Append(PipeDelim);
+		Content.Append(LexToString(InCheckpoint.FileSizes[i])).Append(TEXT("\n"));
+	}
+
+	//Write aside and move over, a crash while saving keeps the previous checkpoint
+	FString FullPath;
+	CreateFilePath(CheckpointRelPath, FullPath);
+	FString TmpPath = FullPath + TEXT(".tmp");
+	if (!FFileHelper::SaveStringToFile(Content, *TmpPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)
+		|| !IFileManager::Get().Move(*FullPath, *TmpPath, true)) {
+		UE_LOG(DataCreator, Warning, TEXT("Save checkpoint %s failed."), *FullPath);
+		return false;
+	}
+	return true;
+}
+
+bool ADataCreator::LoadCheckpoint(const FString& CheckpointRelPath, uint32 Hash)
+{
+	bResumeCheckpoint = false;
+	Checkpoint = FDataCreatorCheckpoint();
+	LastCheckpointTime = FPlatformTime::Seconds();
+	if (!CanUseCheckpoint()) {
+		return false;
+	}
+
+	TArray<FString> Lines;
+	FString FullPath = FPaths::ProjectDir().Append(CheckpointRelPath);
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FullPath) || Lines.Num() < 3) {
+		return false;
+	}
+
+	TArray<FString> Header;
+	int32 Version;
+	FDataCreatorCheckpoint Loaded;
+	Lines[0].TrimStartAndEnd().ParseIntoArray(Header, *PipeDelim, false);
+	if (Header.Num() != 4
+		|| !LexTryParseString(Version, *Header[0]) || Version != DATA_CREATOR_CHECKPOINT_VERSION
+		|| !LexTryParseString(Loaded.ParamsHash, *Header[1]) || Loaded.ParamsHash != Hash
+		|| !LexTryParseString(Loaded.Stage, *Header[2])
+		|| !LexTryParseString(Loaded.LoopCount, *Header[3])) {
+		return false;
+	}
+
+	TArray<FString> Items;
+	Lines[1].TrimStartAndEnd().ParseIntoArray(Items, *CommaDelim, true);
+	for (const FString& Item : Items)
+	{
+		if (!LexTryParseString(Loaded.LoopIndices.AddDefaulted_GetRef(), *Item)) {
+			return false;
+		}
+	}
+	Lines[2].TrimStartAndEnd().ParseIntoArray(Items, *CommaDelim, true);
+	for (const FString& Item : Items)
+	{
+		if (!LexTryParseString(Loaded.Values.AddDefaulted_GetRef(), *Item)) {
+			return false;
+		}
+	}
+
+	//Every file must still hold at least the checkpointed data
+	for (int32 i = 3; i < Lines.Num(); i++)
+	{
+		FString RelPath, Size;
+		if (Lines[i].TrimStartAndEnd().IsEmpty()) {
+			continue;
+		}
+		if (!Lines[i].TrimStartAndEnd().Split(PipeDelim, &RelPath, &Size, ESearchCase::CaseSensitive, ESearchDir::FromEnd)) {
+			return false;
+		}
+		int64& FileSize = Loaded.FileSizes.AddDefaulted_GetRef();
+		if (!LexTryParseString(FileSize, *Size)
+			|| IFileManager::Get().FileSize(*FPaths::ProjectDir().Append(RelPath)) < FileSize) {
+			return false;
+		}
+		Loaded.FileRelPaths.Add(RelPath);
+	}
+
+	Checkpoint = MoveTemp(Loaded);
+	bResumeCheckpoint = true;
+	UE_LOG(DataCreator, Log, TEXT("Resume from checkpoint %s, stage %d."), *FullPath, Checkpoint.Stage);
+	return true;
+}
+
+void ADataCreator::DeleteCheckpoint(const FString& CheckpointRelPath)
+{
+	bResumeCheckpoint = false;
+	LastCheckpointTime = FPlatformTime::Seconds();
+	FString FullPath = FPaths::ProjectDir().Append(CheckpointRelPath);
+	if (FPaths::FileExists(FullPath) && !IFileManager::Get().Delete(*FullPath)) {
+		UE_LOG(DataCreator, Warning, TEXT("Delete checkpoint %s failed."), *FullPath);
+	}
+}
+
+bool ADataCreator::ResumeDataWriter(FBufferedDataWriter& Writer, const FString& FullPath, int64 Size)
+{
+	//Drop whatever was written after the checkpoint, appending then continues the last saved line
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IFileHandle> Handle(PlatformFile.OpenWrite(*FullPath, true, true));
+	if (!Handle || Size < 0 || Handle->Size() < Size || !Handle->Truncate(Size)) {
+		return false;
+	}
+	Handle.Reset();
+	return OpenDataWriter(Writer, FullPath, false, true);
 }
 
 // Called when the game starts or when spawned
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "ChunkedDataFormat.h"
+
+#include <atomic>
+
+class IFileHandle;
+
+/**
+ * Write data file through one open handle.
+ * Text is formatted into a memory buffer, full buffers are flushed on a background task
+ * while the next one is being filled.
+ * With a compression format every buffer is compressed as one chunk of the chunked container.
+ */
+class LOAW_GRIDDATACREATOR_API FBufferedDataWriter
+{
+public:
+	FBufferedDataWriter(int32 InBufferSize = 4 << 20);
+	~FBufferedDataWriter();
+
+	FBufferedDataWriter(const FBufferedDataWriter&) = delete;
+	FBufferedDataWriter& operator=(const FBufferedDataWriter&) = delete;
+
+	//Compression is ignored in append mode, chunked files can not be appended
+	bool Open(const FString& FullPath, bool bAppend = false, FName CompressionFormat = NAME_None, int32 ChunkSize = 256 << 10);
+	//Flush all buffered data and close the file, return false when any write failed
+	bool Close();
+	//Write all buffered data to disk and keep the file open, Tell() is then the file size
+	bool Flush();
+
+	FORCEINLINE bool IsOpen() const
+	{
+		return FileHandle.IsValid();
+	}
+
+	FORCEINLINE bool HasError() const
+	{
+		return bError;
+	}
+
+	//Raw bytes written so far, including data still in buffer
+	FORCEINLINE int64 Tell() const
+	{
+		return FileSize + Buffer.Num();
+	}
+
+	FORCEINLINE bool IsCompressed() const
+	{
+		return !CompressionFormat.IsNone();
+	}
+
+	void WriteRaw(const void* Data, int64 Size);
+	void WriteChar(char Value);
+	void WriteString(const FString& Str);
+	void WriteInt(int64 Value);
+	//Round half from zero, no trailing zeros, same text as FText::AsNumber without grouping
+	void WriteFloat(double Value, int32 MaximumFractionalDigits);
+	void WriteLineEnd();
+
+private:
+	void Reserve(int32 Size);
+	void FlushAsync();
+	void WaitFlush();
+	void WriteChunk(const TArray<uint8>& Data);
+	void WriteChunkTable();
+
+private:
+	int32 BufferSize;
+	int32 Capacity;
+	TArray<uint8> Buffer;
+	TArray<uint8> FlushBuffer;
+
+	TUniquePtr<IFileHandle> FileHandle;
+	UE::Tasks::FTask FlushTask;
+	int64 FileSize = 0;
+
+	//Chunked container state, only touched by the flush task while it is in flight
+	FName CompressionFormat;
+	int32 ChunkCapacity = 0;
+	TArray<uint8> CompressBuffer;
+	TArray<FChunkedDataEntry> ChunkTable;
+	int64 ChunkOffset = 0;
+	std::atomic<bool> bError = false;
+};
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Chunked compressed container written by FBufferedDataWriter and read by FChunkedDataReader.
+//Layout: Chunk[ChunkNum] | Entry[ChunkNum] | Footer
+//Each chunk holds at most ChunkSize raw bytes, a chunk with CompressedSize == RawSize is stored raw.
+#define CHUNKED_DATA_MAGIC		0x9A4B4843
+#define CHUNKED_DATA_VERSION	1
+
+struct FChunkedDataEntry
+{
+	int64 Offset = 0;
+	int32 CompressedSize = 0;
+	int32 RawSize = 0;
+};
+
+struct FChunkedDataFooter
+{
+	int64 TableOffset = 0;
+	int64 RawSize = 0;
+	int32 ChunkNum = 0;
+	int32 ChunkSize = 0;
+	uint32 Format = 0;
+	uint32 Version = CHUNKED_DATA_VERSION;
+	uint32 Reserved = 0;
+	uint32 Magic = CHUNKED_DATA_MAGIC;
+};
+
+static_assert(sizeof(FChunkedDataEntry) == 16, "FChunkedDataEntry layout changed.");
+static_assert(sizeof(FChunkedDataFooter) == 40, "FChunkedDataFooter layout changed.");
+
+class FChunkedDataFormat
+{
+public:
+	//Compression format is stored as index, names are resolved by FCompression
+	static uint32 FormatToIndex(FName FormatName)
+	{
+		if (FormatName == NAME_Zlib) return 1;
+		if (FormatName == NAME_Gzip) return 2;
+		if (FormatName == NAME_LZ4) return 3;
+		if (FormatName == NAME_Oodle) return 4;
+		return 0;
+	}
+
+	static FName IndexToFormat(uint32 Index)
+	{
+		switch (Index)
+		{
+		case 1: return NAME_Zlib;
+		case 2: return NAME_Gzip;
+		case 3: return NAME_LZ4;
+		case 4: return NAME_Oodle;
+		default: return NAME_None;
+		}
+	}
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "ChunkedDataFormat.h"
+
+class IFileHandle;
+
+/**
+ * Sequential reader of chunked container.
+ * Chunks ahead of the read position are decompressed on background tasks.
+ */
+class LOAW_GRIDDATACREATOR_API FChunkedDataReader
+{
+public:
+	FChunkedDataReader(int32 InReadAheadNum = 8);
+	~FChunkedDataReader();
+
+	FChunkedDataReader(const FChunkedDataReader&) = delete;
+	FChunkedDataReader& operator=(const FChunkedDataReader&) = delete;
+
+	//Return false when file is not a valid chunked container
+	bool Open(const FString& FullPath);
+	void Close();
+
+	FORCEINLINE int64 GetRawSize() const
+	{
+		return Footer.RawSize;
+	}
+
+	//Read next Size raw bytes
+	bool Read(uint8* Dest, int64 Size);
+
+	//Read and decompress whole file
+	static bool ReadFile(const FString& FullPath, TArray<uint8>& OutData);
+
+private:
+	struct FChunkSlot
+	{
+		TArray<uint8> Compressed;
+		TArray<uint8> Raw;
+		UE::Tasks::FTask Task;
+		bool bSucceeded = false;
+	};
+
+	void LaunchChunk(int32 ChunkIndex);
+	bool NextChunk();
+
+private:
+	int32 ReadAheadNum;
+	TUniquePtr<IFileHandle> FileHandle;
+	FChunkedDataFooter Footer;
+	TArray<FChunkedDataEntry> ChunkTable;
+	FName CompressionFormat;
+
+	TArray<FChunkSlot> Slots;
+	int32 ConsumeIndex = -1;
+	const uint8* ChunkPtr = nullptr;
+	int64 ChunkRemain = 0;
+};
@@ -3,11 +3,33 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "BufferedDataWriter.h"
 #include "GameFramework/Actor.h"
 #include "DataCreator.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(DataCreator, Log, All);
 
+#define DATA_CREATOR_CHECKPOINT_VERSION	1
+
+//Resume point of an interrupted creation, loop state of one workflow stage and sizes of files written so far
+struct FDataCreatorCheckpoint
+{
+	uint32 ParamsHash = 0;
+	int32 Stage = 0;
+	int32 LoopCount = 0;
+	TArray<int32> LoopIndices;
+	//Creator specific state needed to reopen the same files
+	TArray<int32> Values;
+	TArray<FString> FileRelPaths;
+	TArray<int64> FileSizes;
+
+	FORCEINLINE int64 FindFileSize(const FString& RelPath) const
+	{
+		int32 Index = FileRelPaths.IndexOfByKey(RelPath);
+		return Index == INDEX_NONE ? -1 : FileSizes[Index];
+	}
+};
+
 UCLASS()
 class LOAW_GRIDDATACREATOR_API ADataCreator : public AActor
 {
@@ -28,11 +50,66 @@ protected:
 	FString SpaceDelim = FString(TEXT(" "));
 	FString ColonDelim = FString(TEXT(":"));
 
+	//Shared writer, stays open across timer slices of one write stage
+	FBufferedDataWriter DataWriter;
+
+	//Regenerate even when existing data matches the params hash
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Common")
+	bool bForceRecreate = false;
+
+	//Write large data files as chunked compressed container
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Compression")
+	bool bCompressData = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Compression", meta = (GetOptions = "GetCompressionFormatOptions"))
+	FName CompressionFormat = NAME_Oodle;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Compression", meta = (ClampMin = "4096"))
+	int32 CompressionChunkSize = 256 * 1024;
+
+	//Persist loop state and written file sizes, next CreateData resumes from there, only with uncompressed data
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Checkpoint")
+	bool bUseCheckpoint = true;
+	//Seconds between two checkpoints
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Checkpoint", meta = (ClampMin = "0.0"))
+	float CheckpointInterval = 10.0f;
+
+	//Checkpoint loaded by CreateData, valid while bResumeCheckpoint is set
+	FDataCreatorCheckpoint Checkpoint;
+	bool bResumeCheckpoint = false;
+	double LastCheckpointTime = 0.0;
+
 protected:
 	bool CreateFilePath(const FString& RelPath, FString& FullPath);
-	void WritePipeDelimiter(std::ofstream& ofs);
-	void WriteColonDelimiter(std::ofstream& ofs);
-	void WriteLineEnd(std::ofstream& ofs);
+	//Append keeps existing content and never compresses
+	bool OpenDataWriter(const FString& FullPath, bool bCompress = true, bool bAppend = false);
+	bool OpenDataWriter(FBufferedDataWriter& Writer, const FString& FullPath, bool bCompress = true, bool bAppend = false);
+
+	UFUNCTION()
+	TArray<FName> GetCompressionFormatOptions() const;
+	void WritePipeDelimiter(FBufferedDataWriter& Writer);
+	void WriteCommaDelimiter(FBufferedDataWriter& Writer);
+	void WriteSpaceDelimiter(FBufferedDataWriter& Writer);
+	void WriteColonDelimiter(FBufferedDataWriter& Writer);
+	void WriteLineEnd(FBufferedDataWriter& Writer);
+
+	//Params hash is stored as second line of params data file
+	void WriteParamsHash(FBufferedDataWriter& Writer, uint32 Hash);
+	bool ReadParamsHash(const FString& ParamsRelPath, uint32& Hash);
+	bool IsDataUpToDate(const FString& ParamsRelPath, const TArray<FString>& DataRelPaths, uint32 Hash);
+
+	//Incremental regeneration, read params of existing data and check data files can be appended
+	bool ReadParams(const FString& ParamsRelPath, TArray<FString>& Params, uint32& Hash);
+	bool CanAppendDataFile(const FString& RelPath);
+	//Params data is written last, removing it first marks data files incomplete until done
+	void InvalidateParams(const FString& ParamsRelPath);
+
+	//Checkpoint, data files must be flushed before their sizes are saved
+	bool CanUseCheckpoint() const;
+	bool IsCheckpointDue() const;
+	bool SaveCheckpoint(const FString& CheckpointRelPath, const FDataCreatorCheckpoint& InCheckpoint);
+	bool LoadCheckpoint(const FString& CheckpointRelPath, uint32 Hash);
+	void DeleteCheckpoint(const FString& CheckpointRelPath);
+	//Cut file back to checkpoint size and open it for append
+	bool ResumeDataWriter(FBufferedDataWriter& Writer, const FString& FullPath, int64 Size);
 
 protected:
 	// Called when the game starts or when spawned
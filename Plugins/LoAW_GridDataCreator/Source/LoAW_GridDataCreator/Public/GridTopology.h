@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/IntegerSequence.h"
+
+//Topology traits: SideNum sides per ring, ring Radius starts at Start * Radius and side j walks Side[j] Radius times.
+
+//Hex grid in axial coordinates, sides walk the axial directions, ring starts at direction 4
+struct FHexGridTopology
+{
+	static constexpr int32 SideNum = 6;
+	static constexpr int32 StartX = -1;
+	static constexpr int32 StartY = 1;
+	static constexpr int32 SideX[SideNum] = { 1, 1, 0, -1, -1, 0 };
+	static constexpr int32 SideY[SideNum] = { 0, -1, -1, 0, 1, 1 };
+};
+
+//Quad grid, ring starts at neighbor direction 0 and sides walk the diagonals
+struct FQuadGridTopology
+{
+	static constexpr int32 SideNum = 4;
+	static constexpr int32 StartX = 0;
+	static constexpr int32 StartY = -1;
+	static constexpr int32 SideX[SideNum] = { 1, -1, -1, 1 };
+	static constexpr int32 SideY[SideNum] = { 1, 1, -1, -1 };
+};
+
+/**
+ * Spiral order over a ring topology, center is index 0 and ring i holds SideNum * i points.
+ * Direction tables are constexpr, ring walks are unrolled over sides.
+ */
+template <typename TTopology>
+struct TGridSpiral
+{
+	static constexpr int32 SideNum = TTopology::SideNum;
+
+	static constexpr int32 PointNum(int32 Range)
+	{
+		return 1 + SideNum * Range * (Range + 1) / 2;
+	}
+
+	static constexpr int32 RingBegin(int32 Ring)
+	{
+		return Ring == 0 ? 0 : 1 + SideNum * Ring * (Ring - 1) / 2;
+	}
+
+	//Unit ring corner where side Side begins
+	static constexpr int32 CornerX(int32 Side)
+	{
+		int32 X = TTopology::StartX;
+		for (int32 j = 0; j < Side; j++) X += TTopology::SideX[j];
+		return X;
+	}
+
+	static constexpr int32 CornerY(int32 Side)
+	{
+		int32 Y = TTopology::StartY;
+		for (int32 j = 0; j < Side; j++) Y += TTopology::SideY[j];
+		return Y;
+	}
+
+	static constexpr void RingPoint(int32 Ring, int32 Side, int32 Step, int32& OutX, int32& OutY)
+	{
+		OutX = CornerX(Side) * Ring + TTopology::SideX[Side] * Step;
+		OutY = CornerY(Side) * Ring + TTopology::SideY[Side] * Step;
+	}
+
+	static constexpr int32 IndexToRing(int32 Index)
+	{
+		if (Index <= 0) {
+			return 0;
+		}
+
+		//Largest ring with RingBegin(Ring) <= Index, integer sqrt estimate corrected to exact
+		int64 Value = 8 * int64(Index - 1) / SideNum + 1;
+		int64 Root = Value;
+		int64 Next = (Root + 1) / 2;
+		while (Next < Root)
+		{
+			Root = Next;
+			Next = (Root + Value / Root) / 2;
+		}
+		int32 Ring = int32((1 + Root) / 2);
+		while (RingBegin(Ring + 1) <= Index) Ring++;
+		while (RingBegin(Ring) > Index) Ring--;
+		return Ring;
+	}
+
+	static constexpr void IndexToPoint(int32 Index, int32& OutX, int32& OutY)
+	{
+		int32 Ring = IndexToRing(Index);
+		if (Ring == 0) {
+			OutX = 0;
+			OutY = 0;
+			return;
+		}
+
+		int32 Offset = Index - RingBegin(Ring);
+		RingPoint(Ring, Offset / Ring, Offset % Ring, OutX, OutY);
+	}
+
+	FORCEINLINE static FIntPoint StartDirection()
+	{
+		return FIntPoint(TTopology::StartX, TTopology::StartY);
+	}
+
+	FORCEINLINE static FIntPoint SideDirection(int32 Side)
+	{
+		return FIntPoint(TTopology::SideX[Side], TTopology::SideY[Side]);
+	}
+
+	FORCEINLINE static FIntPoint RingPoint(int32 Ring, int32 Side, int32 Step)
+	{
+		FIntPoint Point;
+		RingPoint(Ring, Side, Step, Point.X, Point.Y);
+		return Point;
+	}
+
+	FORCEINLINE static FIntPoint IndexToPoint(int32 Index)
+	{
+		FIntPoint Point;
+		IndexToPoint(Index, Point.X, Point.Y);
+		return Point;
+	}
+
+	//Calls Func(Coord, Side, Step) for every point of ring Ring around Center in spiral order
+	template <typename FuncType>
+	FORCEINLINE static void ForEachRingPoint(const FIntPoint& Center, int32 Ring, FuncType&& Func)
+	{
+		FIntPoint Coord = Center + StartDirection() * Ring;
+		WalkSides(Coord, Ring, Func, TMakeIntegerSequence<int32, SideNum>());
+	}
+
+private:
+	template <typename FuncType, int32... Sides>
+	FORCEINLINE static void WalkSides(FIntPoint& Coord, int32 Ring, FuncType& Func, TIntegerSequence<int32, Sides...>)
+	{
+		(WalkSide<Sides>(Coord, Ring, Func), ...);
+	}
+
+	template <int32 Side, typename FuncType>
+	FORCEINLINE static void WalkSide(FIntPoint& Coord, int32 Ring, FuncType& Func)
+	{
+		constexpr int32 DirectionX = TTopology::SideX[Side];
+		constexpr int32 DirectionY = TTopology::SideY[Side];
+		for (int32 Step = 0; Step < Ring; Step++)
+		{
+			Func(Coord, Side, Step);
+			Coord.X += DirectionX;
+			Coord.Y += DirectionY;
+		}
+	}
+};
+
+using FHexGridSpiral = TGridSpiral<FHexGridTopology>;
+using FQuadGridSpiral = TGridSpiral<FQuadGridTopology>;
+
+namespace GridTopologyCheck
+{
+	template <typename TTopology>
+	constexpr bool RingCloses()
+	{
+		int32 X = TTopology::StartX, Y = TTopology::StartY;
+		for (int32 j = 0; j < TTopology::SideNum; j++)
+		{
+			X += TTopology::SideX[j];
+			Y += TTopology::SideY[j];
+		}
+		return X == TTopology::StartX && Y == TTopology::StartY;
+	}
+}
+
+static_assert(GridTopologyCheck::RingCloses<FHexGridTopology>() && GridTopologyCheck::RingCloses<FQuadGridTopology>(),
+	"Ring sides must return to the ring start.");
+static_assert(FHexGridSpiral::RingBegin(2) == 7 && FQuadGridSpiral::RingBegin(2) == 5, "Ring begin.");
+static_assert(FHexGridSpiral::IndexToRing(18) == 2 && FHexGridSpiral::IndexToRing(19) == 3
+	&& FQuadGridSpiral::IndexToRing(12) == 2 && FQuadGridSpiral::IndexToRing(13) == 3, "Ring of spiral index.");
@@ -4,74 +4,260 @@
 
 #include "CoreMinimal.h"
 
-class HexCoord
+class Hex;
+
+/**
+ * Fractional axial hex in fixed point with FractionBits fractional bits,
+ * only used on the way from a position to a tile before rounding.
+ */
+class HexFrac
 {
 public:
-	float q = 0.0f;
-	float r = 0.0f;
-	float s = 0.0f;
+	static constexpr int32 FractionBits = 16;
+	static constexpr int64 One = int64(1) << FractionBits;
 
-	int32 Q = 0;
-	int32 R = 0;
-	int32 S = 0;
+	int64 q = 0;
+	int64 r = 0;
 
-	HexCoord();
-	~HexCoord();
+	constexpr HexFrac() = default;
+	constexpr HexFrac(int64 InQ, int64 InR) : q(InQ), r(InR) {}
 
-	void Set(const HexCoord& Coord);
+	constexpr int64 s() const
+	{
+		return -q - r;
+	}
 
+	//Nearest hex, the coordinate with the largest rounding error is rebuilt from the other two
+	constexpr Hex Round() const;
+
+private:
+	static constexpr int64 RoundHalfFromZero(int64 Value)
+	{
+		return Value >= 0 ? (Value + One / 2) / One : -((-Value + One / 2) / One);
+	}
+
+	static constexpr int64 Abs(int64 Value)
+	{
+		return Value < 0 ? -Value : Value;
+	}
 };
 
 /**
- * 
+ * Integer axial hex, trivially copyable and usable in constant expressions.
+ * Cube S is derived, direction tables are static.
+ * World mapping is fixed point: positions and tile size are integers in 1 / PositionScale units, the same
+ * 2 fractional digits written to data files, and sqrt(3) is a Sqrt3Bits fixed-point constant. Every tile center
+ * and corner is computed from its own axial coordinate with integer math, so results are bit-identical across
+ * platforms and thread counts. Positions must stay within +-2^31 fixed units.
  */
 class Hex
 {
-private:
-	HexCoord Coord;
-	TArray<FIntPoint> AxialDirectionVectors = { FIntPoint(1,0), FIntPoint(1,-1),
-		FIntPoint(0,-1), FIntPoint(-1,0),
-		FIntPoint(-1,1), FIntPoint(0,1) };
+public:
+	int32 Q = 0;
+	int32 R = 0;
 
-private:
-	void UpdateCoordFloat(float a, float b);
-	void UpdateCoordInt(int32 A, int32 B);
+	static constexpr int32 DirectionNum = 6;
+	static constexpr int32 DirectionQ[DirectionNum] = { 1, 1, 0, -1, -1, 0 };
+	static constexpr int32 DirectionR[DirectionNum] = { 0, -1, -1, 0, 1, 1 };
+
+	static constexpr int64 PositionScale = 100;
+	static constexpr int32 Sqrt3Bits = 28;
+	static constexpr int64 Sqrt3Fixed = 464943848;
+
+	//Flat top corner k at k * 60 degrees, offsets in units of Size / 2 along X and sqrt(3) * Size / 2 along Y
+	static constexpr int32 CornerX[DirectionNum] = { 2, 1, -1, -2, -1, 1 };
+	static constexpr int32 CornerY[DirectionNum] = { 0, 1, 1, 0, -1, -1 };
 
 public:
-	Hex();
-	Hex(FVector Cube);
-	Hex(FVector2D Axial);
-	Hex(FIntVector CubeInt);
-	Hex(FIntPoint AxialInt);
+	constexpr Hex() = default;
+	constexpr Hex(int32 InQ, int32 InR) : Q(InQ), R(InR) {}
+	explicit Hex(const FIntPoint& AxialInt) : Q(AxialInt.X), R(AxialInt.Y) {}
+	explicit Hex(const FIntVector& CubeInt) : Q(CubeInt.X), R(CubeInt.Y) {}
+
+	constexpr int32 S() const
+	{
+		return -Q - R;
+	}
+
+	FORCEINLINE void SetAxialInt(const FIntPoint& AxialInt)
+	{
+		Q = AxialInt.X;
+		R = AxialInt.Y;
+	}
 
-	void SetCube(const FVector Cube);
-	void SetAxial(const FVector2D Axial);
-	void SetCubeInt(const FIntVector CubeInt);
-	void SetAxialInt(const FIntPoint AxialInt);
-	void SetHex(const Hex& hex);
+	FORCEINLINE void SetCubeInt(const FIntVector& CubeInt)
+	{
+		Q = CubeInt.X;
+		R = CubeInt.Y;
+	}
 
-	HexCoord GetCoord();
+	FORCEINLINE void SetHex(const Hex& InHex)
+	{
+		*this = InHex;
+	}
 
-	static Hex Round(const Hex& InHex);
-	static Hex Add(const Hex& InHexA, const Hex& InHexB);
-	static Hex Subtract(const Hex& InHexA, const Hex& InHexB);
-	static Hex Scale(const Hex& InHex, float Factor);
-	static Hex Direction(int32 Direction);
-	static Hex Neighbor(const Hex& InHex, int32 direction);
-	static float Distance(const Hex& InHexA, const Hex& InHexB);
-	static Hex PosToHex(const FVector2D& Point, float Size);
+	FORCEINLINE FIntPoint ToIntPoint() const
+	{
+		return FIntPoint(Q, R);
+	}
+
+	FORCEINLINE FIntVector ToCubeInt() const
+	{
+		return FIntVector(Q, R, S());
+	}
 
+	static constexpr Hex Add(const Hex& InHexA, const Hex& InHexB)
+	{
+		return Hex(InHexA.Q + InHexB.Q, InHexA.R + InHexB.R);
+	}
+
+	static constexpr Hex Subtract(const Hex& InHexA, const Hex& InHexB)
+	{
+		return Hex(InHexA.Q - InHexB.Q, InHexA.R - InHexB.R);
+	}
+
+	static constexpr Hex Scale(const Hex& InHex, int32 Factor)
+	{
+		return Hex(InHex.Q * Factor, InHex.R * Factor);
+	}
+
+	static constexpr Hex Direction(int32 Direction)
+	{
+		return Hex(DirectionQ[Direction], DirectionR[Direction]);
+	}
+
+	static constexpr Hex Neighbor(const Hex& InHex, int32 Direction)
+	{
+		return Hex(InHex.Q + DirectionQ[Direction], InHex.R + DirectionR[Direction]);
+	}
 
-	FORCEINLINE bool operator==(const Hex& InHex) const
+	static constexpr int32 Distance(const Hex& InHexA, const Hex& InHexB)
 	{
-		return (Coord.Q == InHex.Coord.Q && Coord.R == InHex.Coord.R);
+		Hex Diff = Subtract(InHexA, InHexB);
+		int32 AbsQ = Diff.Q < 0 ? -Diff.Q : Diff.Q;
+		int32 AbsR = Diff.R < 0 ? -Diff.R : Diff.R;
+		int32 AbsS = Diff.S() < 0 ? -Diff.S() : Diff.S();
+		return (AbsQ + AbsR + AbsS) / 2;
 	}
 
-	FORCEINLINE FIntPoint ToIntPoint()
+	static constexpr int64 RoundDiv(int64 Num, int64 Den)
 	{
-		return FIntPoint(Coord.Q, Coord.R);
+		return Num >= 0 ? (Num + Den / 2) / Den : -((-Num + Den / 2) / Den);
 	}
 
-	~Hex();
+	static constexpr int64 FloorDiv(int64 Num, int64 Den)
+	{
+		return Num >= 0 ? Num / Den : -((-Num + Den - 1) / Den);
+	}
+
+	//Tile center in fixed units, X = 3 / 2 * Size * Q and Y = sqrt(3) * Size * (R + Q / 2)
+	static constexpr void AxialToFixed(int64 FixedSize, int32 Q, int32 R, int64& OutX, int64& OutY)
+	{
+		OutX = RoundDiv(FixedSize * 3 * Q, 2);
+		OutY = RoundDiv(Sqrt3Fixed * FixedSize * (2 * int64(R) + Q), int64(2) << Sqrt3Bits);
+	}
+
+	//Corner position depends on the corner only, every tile sharing it gets the same value
+	static constexpr void CornerToFixed(int64 FixedSize, int32 Q, int32 R, int32 Corner, int64& OutX, int64& OutY)
+	{
+		OutX = RoundDiv(FixedSize * (3 * int64(Q) + CornerX[Corner]), 2);
+		OutY = RoundDiv(Sqrt3Fixed * FixedSize * (2 * int64(R) + Q + CornerY[Corner]), int64(2) << Sqrt3Bits);
+	}
+
+	//Inverse of AxialToFixed, q = 2 / 3 * X / Size and r = (sqrt(3) * Y - X) / (3 * Size)
+	static constexpr HexFrac FixedToHexFrac(int64 FixedSize, int64 X, int64 Y)
+	{
+		return HexFrac(FloorDiv(2 * X * HexFrac::One, 3 * FixedSize),
+			FloorDiv(Sqrt3Fixed * Y - X * (int64(1) << Sqrt3Bits), (3 * FixedSize) << (Sqrt3Bits - HexFrac::FractionBits)));
+	}
+
+	FORCEINLINE static int64 ToFixed(double Value)
+	{
+		return int64(FMath::RoundHalfFromZero(Value * double(PositionScale)));
+	}
+
+	FORCEINLINE static FVector2D FixedToPosition(int64 X, int64 Y)
+	{
+		return FVector2D(double(X) / double(PositionScale), double(Y) / double(PositionScale));
+	}
+
+	FORCEINLINE static FVector2D AxialToPosition(int64 FixedSize, const FIntPoint& Axial)
+	{
+		int64 X = 0, Y = 0;
+		AxialToFixed(FixedSize, Axial.X, Axial.Y, X, Y);
+		return FixedToPosition(X, Y);
+	}
+
+	FORCEINLINE static FVector2D CornerPosition(int64 FixedSize, const FIntPoint& Axial, int32 Corner)
+	{
+		int64 X = 0, Y = 0;
+		CornerToFixed(FixedSize, Axial.X, Axial.Y, Corner, X, Y);
+		return FixedToPosition(X, Y);
+	}
+
+	FORCEINLINE static HexFrac PosToHexFrac(const FVector2D& Point, int64 FixedSize)
+	{
+		return FixedToHexFrac(FixedSize, ToFixed(Point.X), ToFixed(Point.Y));
+	}
+
+	FORCEINLINE static Hex PosToHex(const FVector2D& Point, int64 FixedSize)
+	{
+		return PosToHexFrac(Point, FixedSize).Round();
+	}
+
+	constexpr bool operator==(const Hex& InHex) const
+	{
+		return (Q == InHex.Q && R == InHex.R);
+	}
+
+	constexpr bool operator!=(const Hex& InHex) const
+	{
+		return !(*this == InHex);
+	}
 };
 
+constexpr Hex HexFrac::Round() const
+{
+	int64 rq = RoundHalfFromZero(q);
+	int64 rr = RoundHalfFromZero(r);
+	int64 rs = RoundHalfFromZero(s());
+
+	int64 q_diff = Abs(rq * One - q);
+	int64 r_diff = Abs(rr * One - r);
+	int64 s_diff = Abs(rs * One - s());
+
+	if (q_diff > r_diff && q_diff > s_diff) {
+		rq = -rr - rs;
+	}
+	else if (r_diff > s_diff) {
+		rr = -rq - rs;
+	}
+
+	return Hex(int32(rq), int32(rr));
+}
+
+namespace HexCheck
+{
+	constexpr bool CenterRoundTrip(int64 FixedSize, int32 Q, int32 R)
+	{
+		int64 X = 0, Y = 0;
+		Hex::AxialToFixed(FixedSize, Q, R, X, Y);
+		return Hex::FixedToHexFrac(FixedSize, X, Y).Round() == Hex(Q, R);
+	}
+
+	constexpr bool CornerShared(int64 FixedSize)
+	{
+		int64 X0 = 0, Y0 = 0, X1 = 0, Y1 = 0, X2 = 0, Y2 = 0;
+		Hex::CornerToFixed(FixedSize, 0, 0, 1, X0, Y0);
+		Hex::CornerToFixed(FixedSize, 0, 1, 5, X1, Y1);
+		Hex::CornerToFixed(FixedSize, 1, 0, 3, X2, Y2);
+		return X0 == X1 && X0 == X2 && Y0 == Y1 && Y0 == Y2;
+	}
+}
+
+static_assert(HexCheck::CenterRoundTrip(50000, 1, 0) && HexCheck::CenterRoundTrip(50000, -3, 5)
+	&& HexCheck::CenterRoundTrip(777, 100, -40), "Tile center maps back to its hex.");
+static_assert(HexCheck::CornerShared(50000) && HexCheck::CornerShared(777), "Shared corner has one position.");
+static_assert(std::is_trivially_copyable_v<Hex> && std::is_trivially_copyable_v<HexFrac>, "Hex types are plain values.");
+static_assert(Hex::Distance(Hex::Scale(Hex::Direction(4), 3), Hex()) == 3, "Hex distance of a scaled direction.");
+static_assert(Hex::Neighbor(Hex::Direction(0), 3) == Hex(), "Opposite directions cancel.");
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexSpiral.h"
+
+/**
+ * Super-hex chunks of radius N tile the axial grid.
+ * Chunk (A, B) is centered at A * (2N + 1, -N) + B * (N, N + 1), both basis vectors are 2N + 1 tiles long
+ * and 60 degrees apart, so a tile belongs to one of the 4 chunks around its lattice cell.
+ */
+struct FHexChunkLattice
+{
+	static constexpr int32 ChunkTileNum(int32 Radius)
+	{
+		return FHexSpiral::TileNum(Radius);
+	}
+
+	static constexpr int32 FloorDiv(int64 Num, int64 Den)
+	{
+		return int32(Num >= 0 ? Num / Den : -((-Num + Den - 1) / Den));
+	}
+
+	static constexpr void ChunkToAxial(int32 Radius, int32 A, int32 B, int32& OutQ, int32& OutR)
+	{
+		OutQ = A * (2 * Radius + 1) + B * Radius;
+		OutR = -A * Radius + B * (Radius + 1);
+	}
+
+	static constexpr void AxialToChunk(int32 Radius, int32 Q, int32 R, int32& OutA, int32& OutB)
+	{
+		int64 Det = ChunkTileNum(Radius);
+		int32 FloorA = FloorDiv(int64(Radius + 1) * Q - int64(Radius) * R, Det);
+		int32 FloorB = FloorDiv(int64(Radius) * Q + int64(2 * Radius + 1) * R, Det);
+		OutA = FloorA;
+		OutB = FloorB;
+		for (int32 i = 0; i < 4; i++)
+		{
+			int32 A = FloorA + (i & 1);
+			int32 B = FloorB + (i >> 1);
+			int32 CenterQ = 0, CenterR = 0;
+			ChunkToAxial(Radius, A, B, CenterQ, CenterR);
+			if (FHexSpiral::Distance(Q - CenterQ, R - CenterR) <= Radius) {
+				OutA = A;
+				OutB = B;
+				return;
+			}
+		}
+	}
+
+	FORCEINLINE static FIntPoint AxialToChunk(int32 Radius, const FIntPoint& Axial)
+	{
+		FIntPoint Chunk;
+		AxialToChunk(Radius, Axial.X, Axial.Y, Chunk.X, Chunk.Y);
+		return Chunk;
+	}
+};
+
+//Tiles of one super-hex with bounds and aggregate tile state for culling queries
+struct FHexGridChunk
+{
+	FIntPoint ChunkCoord = FIntPoint(0, 0);
+	TArray<int32> TileIndices;
+	FBox2D Bounds = FBox2D(ForceInit);
+	float MinPositionZ = 0.f;
+	float MaxPositionZ = 0.f;
+	int32 MaxAreaBlockLevel = 0;
+	int32 MaxBuildingBlockLevel = 0;
+};
+
+namespace HexChunkCheck
+{
+	constexpr bool CenterRoundTrip(int32 Radius, int32 A, int32 B)
+	{
+		int32 Q = 0, R = 0, OutA = 0, OutB = 0;
+		FHexChunkLattice::ChunkToAxial(Radius, A, B, Q, R);
+		FHexChunkLattice::AxialToChunk(Radius, Q, R, OutA, OutB);
+		return OutA == A && OutB == B;
+	}
+}
+
+static_assert(HexChunkCheck::CenterRoundTrip(4, 0, 0) && HexChunkCheck::CenterRoundTrip(4, -3, 2)
+	&& HexChunkCheck::CenterRoundTrip(1, 5, -7), "Chunk center maps back to its chunk.");
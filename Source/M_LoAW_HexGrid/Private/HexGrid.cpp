@@ -3,17 +3,19 @@
 
 #include "HexGrid.h"
 #include "HexGridCreator.h"
+#include "HexGridDataLoader.h"
 #include "M_LoAW_Terrain/Public/Terrain.h"
 #include "M_LoAW_Terrain/Public/FlowControlUtility.h"
 
 #include <Components/InstancedStaticMeshComponent.h>
 #include <EnhancedInputSubsystems.h>
 #include <EnhancedInputComponent.h>
-#include <string>
-#include <kismet/KismetStringLibrary.h>
-#include <String/LexFromString.h>
 #include <Kismet/GameplayStatics.h>
 #include <Kismet/KismetMathLibrary.h>
+#include <Async/ParallelFor.h>
+#include <Algo/Sort.h>
+#include <HAL/PlatformFileManager.h>
+#include <Async/MappedFileHandle.h>
 
 DEFINE_LOG_CATEGORY(HexGrid);
 
@@ -151,17 +153,17 @@ void AHexGrid::CreateHexGridFlow()
 	case Enum_HexGridWorkflowState::InitWorkflow:
 		InitWorkflow();
 		break;
-	case Enum_HexGridWorkflowState::LoadParams:
-		LoadParamsFromFile();
+	case Enum_HexGridWorkflowState::WaitTerrainBounds:
+		WaitTerrainBounds();
 		break;
-	case Enum_HexGridWorkflowState::LoadTileIndices:
-		LoadTileIndicesFromFile();
+	case Enum_HexGridWorkflowState::LoadData:
+		LoadData();
 		break;
-	case Enum_HexGridWorkflowState::LoadTiles:
-		LoadTilesFromFile();
+	case Enum_HexGridWorkflowState::WaitLoadData:
+		WaitLoadData();
 		break;
-	case Enum_HexGridWorkflowState::LoadNeighbors:
-		LoadNeighborsFromFile();
+	case Enum_HexGridWorkflowState::CreateTilesNeighbors:
+		CreateTilesNeighbors();
 		break;
 	case Enum_HexGridWorkflowState::CreateTilesVertices:
 		CreateTilesVertices();
@@ -195,6 +197,9 @@ void AHexGrid::CreateHexGridFlow()
 	case Enum_HexGridWorkflowState::SetTilesBuildingBlockLevelEx:
 		SetTilesBuildingBlockLevelEx();
 		break;
+	case Enum_HexGridWorkflowState::SaveSnapshot:
+		SaveSnapshot();
+		break;
 	case Enum_HexGridWorkflowState::AddInstances:
 		AddTilesInstance();
 		break;
@@ -213,17 +218,18 @@ void AHexGrid::InitWorkflow()
 	InitLoopData();
 
 	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridWorkflowState::LoadParams;
+	if (bPartialLoad && bPartialLoadTerrainBounds) {
+		WorkflowState = Enum_HexGridWorkflowState::WaitTerrainBounds;
+	}
+	else {
+		WorkflowState = Enum_HexGridWorkflowState::LoadData;
+	}
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 	UE_LOG(HexGrid, Log, TEXT("Init workflow done!"));
 }
 
 void AHexGrid::InitLoopData()
 {
-	FlowControlUtility::InitLoopData(LoadTileIndicesLoopData);
-	FlowControlUtility::InitLoopData(LoadTilesLoopData);
-	FlowControlUtility::InitLoopData(LoadNeighborsLoopData);
-	LoadNeighborsLoopData.IndexSaved[0] = 1;
 	FlowControlUtility::InitLoopData(CreateTilesVerticesLoopData);
 
 	FlowControlUtility::InitLoopData(SetTilesPosZLoopData);
@@ -261,348 +267,280 @@ void AHexGrid::InitBulidingBlockLevelExLoopDatas()
 	}
 }
 
-bool AHexGrid::GetValidFilePath(const FString& RelPath, FString& FullPath)
-{
-	bool flag = false;
-	FullPath = FPaths::ProjectDir().Append(RelPath);
-	if (FPaths::FileExists(FullPath)) {
-		flag = true;
-	}
-	return flag;
-}
-
-void AHexGrid::LoadParamsFromFile()
+void AHexGrid::WaitTerrainBounds()
 {
 	FTimerHandle TimerHandle;
-	FString FullPath;
-	if (!GetValidFilePath(ParamsDataPath, FullPath)) {
-		UE_LOG(HexGrid, Warning, TEXT("Params data file %s not exist!"), *ParamsDataPath);
-		WorkflowState = Enum_HexGridWorkflowState::Error;
+	if (!FindTerrain()) {
 		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 		return;
 	}
 
-	DataLoadStream.open(*FullPath, std::ios::in);
+	//Same range as IsInMapRange
+	FVector2D HalfSize(Terrain->GetWidth() / 2.0, Terrain->GetHeight() / 2.0);
+	PartialLoadBounds = FBox2D(-HalfSize, HalfSize);
 
-	if (!DataLoadStream || !DataLoadStream.is_open()) {
-		UE_LOG(HexGrid, Warning, TEXT("Open file %s failed!"), *FullPath);
-		WorkflowState = Enum_HexGridWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
-		return;
-	}
-	LoadParams(DataLoadStream);
+	WorkflowState = Enum_HexGridWorkflowState::LoadData;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGrid, Log, TEXT("Wait terrain bounds done!"));
 }
 
-void AHexGrid::LoadParams(std::ifstream& ifs)
+bool AHexGrid::FindTerrain()
 {
-	FTimerHandle TimerHandle;
-	std::string line;
-	std::getline(ifs, line);
-	FString fline(line.c_str());
-	if (!ParseParams(fline)) {
-		ifs.close();
-		UE_LOG(HexGrid, Warning, TEXT("Parse Parameters error!"));
-		WorkflowState = Enum_HexGridWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
-		return;
+	TArray<AActor*> Out_Actors;
+	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ATerrain::StaticClass(), Out_Actors);
+	if (Out_Actors.Num() == 1) {
+		Terrain = (ATerrain*)Out_Actors[0];
+		return Terrain->IsWorkFlowStepDone(Enum_TerrainWorkflowState::InitWorkflow);
 	}
-
-	ifs.close();
-	WorkflowState = Enum_HexGridWorkflowState::LoadTileIndices;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
-	UE_LOG(HexGrid, Log, TEXT("Load params done!"));
+	return false;
 }
 
-bool AHexGrid::ParseParams(const FString& line)
+void AHexGrid::LoadData()
 {
-	TArray<FString> StrArr;
-	line.ParseIntoArray(StrArr, *PipeDelim, true);
+	DataLoader = MakeShared<FHexGridDataLoader>();
+	DataLoader->ParamsDataPath = FPaths::ProjectDir().Append(ParamsDataPath);
+	DataLoader->TilesDataPath = FPaths::ProjectDir().Append(TilesDataPath);
+	DataLoader->BinaryDataPath = FPaths::ProjectDir().Append(BinaryDataPath);
+	DataLoader->bUseBinaryData = bUseBinaryData;
+	DataLoader->ParamNum = ParamNum;
+	DataLoader->bPartialLoad = bPartialLoad;
+	DataLoader->LoadBounds = PartialLoadBounds;
 
-	if (StrArr.Num() != ParamNum) {
-		return false;
-	}
+	//Parse files on worker thread, game thread only polls the task
+	TSharedPtr<FHexGridDataLoader> Loader = DataLoader;
+	DataLoadTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Loader]() { Loader->Load(); });
 
-	//TileSize = UKismetStringLibrary::Conv_StringToFloat(StrArr[0]);
-	LexFromString(TileSize, StrArr[0]);
-	GridRange = UKismetStringLibrary::Conv_StringToInt(StrArr[1]);
-	NeighborRange = UKismetStringLibrary::Conv_StringToInt(StrArr[2]);
-	return true;
+	FTimerHandle TimerHandle;
+	WorkflowState = Enum_HexGridWorkflowState::WaitLoadData;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGrid, Log, TEXT("Start loading data!"));
 }
 
-void AHexGrid::LoadTileIndicesFromFile()
+void AHexGrid::WaitLoadData()
 {
 	FTimerHandle TimerHandle;
-	FString FullPath;
-	if (!GetValidFilePath(TileIndicesDataPath, FullPath)) {
-		UE_LOG(HexGrid, Warning, TEXT("TileIndices data file %s not exist!"), *TileIndicesDataPath);
-		WorkflowState = Enum_HexGridWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadTileIndicesLoopData.Rate, false);
+	if (!DataLoadTask.IsCompleted()) {
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WaitLoadDataRate, false);
 		return;
 	}
 
-	if (!LoadTileIndicesLoopData.HasInitialized) {
-		LoadTileIndicesLoopData.HasInitialized = true;
-		DataLoadStream.open(*FullPath, std::ios::in);
-	}
-
-	if (!DataLoadStream || !DataLoadStream.is_open()) {
-		UE_LOG(HexGrid, Warning, TEXT("Open file %s failed!"), *FullPath);
+	if (!DataLoader->bSucceeded) {
+		UE_LOG(HexGrid, Warning, TEXT("Load data failed!"));
+		DataLoader.Reset();
 		WorkflowState = Enum_HexGridWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadTileIndicesLoopData.Rate, false);
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 		return;
 	}
 
-	LoadTileIndices(DataLoadStream);
-}
-
-void AHexGrid::LoadTileIndices(std::ifstream& ifs)
-{
-	int32 Count = 0;
-	TArray<int32> Indices = { 0 };
-	bool SaveLoopFlag = false;
+	TileSize = DataLoader->TileSize;
+	FixedTileSize = Hex::ToFixed(TileSize);
+	GridRange = DataLoader->GridRange;
+	NeighborRange = DataLoader->NeighborRange;
 
-	std::string line;
-	while (std::getline(ifs, line))
-	{
-		FString fline(line.c_str());
-		ParseTileIndexLine(fline);
-		Count++;
+	//Position to hex divides by the fixed tile size
+	if (FixedTileSize <= 0) {
+		UE_LOG(HexGrid, Warning, TEXT("Tile size %f rounds to a non-positive fixed size!"), TileSize);
+		DataLoader.Reset();
+		WorkflowState = Enum_HexGridWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
+	}
 
-		FlowControlUtility::SaveLoopData(this, LoadTileIndicesLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
-		if (SaveLoopFlag) {
-			return;
-		}
+	//Tile block levels are stored as uint8
+	int32 BlockLevelLimit = NeighborRange * (FMath::Max(AreaBlockExTimes, BuildingBlockExTimes) + 1) + 1;
+	if (BlockLevelLimit > MAX_uint8) {
+		UE_LOG(HexGrid, Warning, TEXT("Block level %d exceeds %d, reduce NeighborRange or block extension times!"), BlockLevelLimit, MAX_uint8);
+		DataLoader.Reset();
+		WorkflowState = Enum_HexGridWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
 	}
 
-	ifs.close();
-	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridWorkflowState::LoadTiles;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadTileIndicesLoopData.Rate, false);
-	UE_LOG(HexGrid, Log, TEXT("Load tile indices done!"));
+	SortTilesByOrder(DataLoader->Tiles);
+	Tiles.Init(DataLoader->Tiles);
+	InitTilesPosition2D();
+	TileMap = MoveTemp(DataLoader->TileMap);
+	DataLoader.Reset();
+	BuildDenseTileLookup();
+	BuildChunks();
+
+	WorkflowState = Enum_HexGridWorkflowState::CreateTilesNeighbors;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGrid, Log, TEXT("Load data done!"));
 }
 
-void AHexGrid::ParseTileIndexLine(const FString& line)
+void AHexGrid::InitTilesPosition2D()
 {
-	TArray<FString> StrArr;
-	FIntPoint key;
-	int32 value;
-	line.ParseIntoArray(StrArr, *PipeDelim, true);
-	ParseIntPoint(StrArr[0], key);
-	ParseInt(StrArr[1], value);
-	TileIndices.Add(key, value);
+	//Loaded positions went through text or float records, recompute them in fixed point from axial coords
+	ParallelFor(Tiles.Num(), [this](int32 Index) {
+		Tiles.Position2D[Index] = Hex::AxialToPosition(FixedTileSize, Tiles.AxialCoord[Index]);
+		});
 }
 
-void AHexGrid::LoadTilesFromFile()
+void AHexGrid::SortTilesByOrder(TArray<FStructHexTileData>& LoadedTiles)
 {
-	FTimerHandle TimerHandle;
-	FString FullPath;
-	if (!GetValidFilePath(TilesDataPath, FullPath)) {
-		UE_LOG(HexGrid, Warning, TEXT("Tiles data file %s not exist!"), *TilesDataPath);
-		WorkflowState = Enum_HexGridWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadTilesLoopData.Rate, false);
+	TileRemap.Empty();
+	if (TileOrder != Enum_HexGridTileOrder::Morton || LoadedTiles.Num() <= 1) {
 		return;
 	}
 
-	if (!LoadTilesLoopData.HasInitialized) {
-		LoadTilesLoopData.HasInitialized = true;
-		DataLoadStream.open(*FullPath, std::ios::in);
+	//Axial coordinates are shifted to non negative, MortonCode2 keeps 16 bits per axis
+	if (2 * int64(GridRange) + 1 > 65536) {
+		UE_LOG(HexGrid, Error, TEXT("GridRange %d exceeds 16 bit Morton keys, keep spiral tile order!"), GridRange);
+		return;
 	}
 
-	if (!DataLoadStream || !DataLoadStream.is_open()) {
-		UE_LOG(HexGrid, Warning, TEXT("Open file %s failed!"), *FullPath);
-		WorkflowState = Enum_HexGridWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadTilesLoopData.Rate, false);
-		return;
+	TArray<uint32> Keys;
+	TArray<int32> Order;
+	Keys.SetNumUninitialized(LoadedTiles.Num());
+	Order.SetNumUninitialized(LoadedTiles.Num());
+	for (int32 i = 0; i < LoadedTiles.Num(); i++)
+	{
+		FIntPoint Cell = LoadedTiles[i].AxialCoord + FIntPoint(GridRange, GridRange);
+		Keys[i] = FMath::MortonCode2(uint32(Cell.X)) | (FMath::MortonCode2(uint32(Cell.Y)) << 1);
+		Order[i] = i;
 	}
+	Algo::SortBy(Order, [&Keys](int32 i) { return Keys[i]; });
 
-	LoadTiles(DataLoadStream);
+	//Loaded tiles are in spiral order, TileMap keeps resolving to that position
+	TArray<FStructHexTileData> Sorted;
+	Sorted.Reserve(LoadedTiles.Num());
+	TileRemap.SetNumUninitialized(LoadedTiles.Num());
+	for (int32 i = 0; i < Order.Num(); i++)
+	{
+		Sorted.Add(MoveTemp(LoadedTiles[Order[i]]));
+		TileRemap[Order[i]] = i;
+	}
+	LoadedTiles = MoveTemp(Sorted);
+	UE_LOG(HexGrid, Log, TEXT("Sort %d tiles in Morton order."), LoadedTiles.Num());
 }
 
-void AHexGrid::LoadTiles(std::ifstream& ifs)
+void AHexGrid::BuildDenseTileLookup()
 {
-	int32 Count = 0;
-	TArray<int32> Indices = { 0 };
-	bool SaveLoopFlag = false;
+	DenseTileLookup.Empty();
+	DenseLookupSize = FIntPoint(0, 0);
+	if (!bDenseTileLookup || Tiles.IsEmpty()) {
+		return;
+	}
 
-	std::string line;
-	while (std::getline(ifs, line))
+	//Partial load only covers the axial bounds of loaded tiles
+	FIntPoint Min = Tiles.AxialCoord[0];
+	FIntPoint Max = Tiles.AxialCoord[0];
+	for (const FIntPoint& AxialCoord : Tiles.AxialCoord)
 	{
-		FString fline(line.c_str());
-		FStructHexTileData Data;
-		ParseTileLine(fline, Data);
-		Tiles.Add(Data);
-		Count++;
-
-		FlowControlUtility::SaveLoopData(this, LoadTilesLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
-		if (SaveLoopFlag) {
-			return;
-		}
+		Min = Min.ComponentMin(AxialCoord);
+		Max = Max.ComponentMax(AxialCoord);
 	}
 
-	ifs.close();
-	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridWorkflowState::LoadNeighbors;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadTilesLoopData.Rate, false);
-	UE_LOG(HexGrid, Log, TEXT("Load tiles done!"));
-}
-
-void AHexGrid::ParseTileLine(const FString& line, FStructHexTileData& Data)
-{
-	TArray<FString> StrArr;
-	line.ParseIntoArray(StrArr, *PipeDelim, true);
-	ParseAxialCoord(StrArr[0], Data);
-	ParsePosition2D(StrArr[1], Data);
+	FIntPoint Size = Max - Min + FIntPoint(1, 1);
+	DenseTileLookup.Init(INDEX_NONE, Size.X * Size.Y);
+	for (int32 i = 0; i < Tiles.Num(); i++)
+	{
+		FIntPoint Cell = Tiles.AxialCoord[i] - Min;
+		DenseTileLookup[Cell.Y * Size.X + Cell.X] = i;
+	}
+	DenseLookupMin = Min;
+	DenseLookupSize = Size;
+	UE_LOG(HexGrid, Log, TEXT("Dense tile lookup %d x %d for %d tiles."), Size.X, Size.Y, Tiles.Num());
 }
 
-void AHexGrid::ParseIndex(const FString& ValueStr, const FString& KeyStr)
+void AHexGrid::BuildChunks()
 {
-	FIntPoint key;
-	int32 value;
-	ParseIntPoint(KeyStr, key);
-	ParseInt(ValueStr, value);
-	TileIndices.Add(key, value);
-}
+	Chunks.Empty();
+	ChunkIndices.Empty();
 
-void AHexGrid::ParseAxialCoord(const FString& Str, FStructHexTileData& Data)
-{
-	ParseIntPoint(Str, Data.AxialCoord);
-}
+	FVector2D TileExtent(TileSize, TileSize);
+	for (int32 i = 0; i < Tiles.Num(); i++)
+	{
+		FIntPoint ChunkCoord = FHexChunkLattice::AxialToChunk(ChunkRadius, Tiles.AxialCoord[i]);
+		int32* Found = ChunkIndices.Find(ChunkCoord);
+		int32 ChunkIndex = Found ? *Found : INDEX_NONE;
+		if (ChunkIndex == INDEX_NONE) {
+			ChunkIndex = Chunks.Num();
+			ChunkIndices.Add(ChunkCoord, ChunkIndex);
+			FHexGridChunk& NewChunk = Chunks.AddDefaulted_GetRef();
+			NewChunk.ChunkCoord = ChunkCoord;
+			NewChunk.TileIndices.Reserve(FHexChunkLattice::ChunkTileNum(ChunkRadius));
+		}
 
-void AHexGrid::ParsePosition2D(const FString& Str, FStructHexTileData& Data)
-{
-	ParseVector2D(Str, Data.Position2D);
+		FHexGridChunk& Chunk = Chunks[ChunkIndex];
+		Chunk.TileIndices.Add(i);
+		Chunk.Bounds += FBox2D(Tiles.Position2D[i] - TileExtent, Tiles.Position2D[i] + TileExtent);
+	}
+	UE_LOG(HexGrid, Log, TEXT("Build %d chunks of radius %d."), Chunks.Num(), ChunkRadius);
 }
 
-void AHexGrid::LoadNeighborsFromFile()
+void AHexGrid::CreateTilesNeighbors()
 {
-	int32 i = LoadNeighborsLoopData.IndexSaved[0];
-	FTimerHandle TimerHandle;
+	InitRingOffsets();
 
-	for (; i <= NeighborRange; i++)
+	//Count every ring first, prefix sum gives row offsets, then fill rows in place
+	int32 RowNum = Tiles.Num() * NeighborRange;
+	NeighborOffsets.Init(0, RowNum + 1);
+	ParallelFor(Tiles.Num(), [this](int32 Index) { CountTileNeighbors(Index); });
+	for (int32 Row = 0; Row < RowNum; Row++)
 	{
-		FString NeighborPath;
-		FString FullPath;
-		CreateNeighborPath(NeighborPath, i);
-
-		if (!GetValidFilePath(NeighborPath, FullPath)) {
-			UE_LOG(HexGrid, Warning, TEXT("Neighbor path file %s not exist!"), *NeighborPath);
-			WorkflowState = Enum_HexGridWorkflowState::Error;
-			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadNeighborsLoopData.Rate, false);
-			return;
-		}
-
-		if (!LoadNeighborsLoopData.HasInitialized) {
-			LoadNeighborsLoopData.HasInitialized = true;
-			DataLoadStream.open(*FullPath, std::ios::in);
-		}
-
-		if (!DataLoadStream || !DataLoadStream.is_open()) {
-			UE_LOG(HexGrid, Warning, TEXT("Open file %s failed!"), *FullPath);
-			WorkflowState = Enum_HexGridWorkflowState::Error;
-			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadNeighborsLoopData.Rate, false);
-			return;
-		}
-		if (!LoadNeighbors(DataLoadStream, i)) {
-			return;
-		}
+		NeighborOffsets[Row + 1] += NeighborOffsets[Row];
 	}
+	NeighborIndices.SetNumUninitialized(NeighborOffsets[RowNum]);
+	ParallelFor(Tiles.Num(), [this](int32 Index) { FillTileNeighbors(Index); });
 
+	FTimerHandle TimerHandle;
 	WorkflowState = Enum_HexGridWorkflowState::CreateTilesVertices;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, LoadNeighborsLoopData.Rate, false);
-	UE_LOG(HexGrid, Log, TEXT("Load neighbors done!"));
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGrid, Log, TEXT("Create tiles neighbors done!"));
 }
 
-void AHexGrid::CreateNeighborPath(FString& NeighborPath, int32 Radius)
+void AHexGrid::InitRingOffsets()
 {
-	NeighborPath.Append(NeighborsDataPathPrefix).Append(FString::FromInt(Radius)).Append(FString(TEXT(".data")));
+	RingOffsets.Empty(3 * NeighborRange * (NeighborRange + 1));
+	for (int32 Radius = 1; Radius <= NeighborRange; Radius++)
+	{
+		FindRingNeighbors(RingOffsets, FIntPoint(0, 0), Radius);
+	}
 }
 
-bool AHexGrid::LoadNeighbors(std::ifstream& ifs, int32 Radius)
+void AHexGrid::CountTileNeighbors(int32 Index)
 {
-	int32 Count = 0;
-	TArray<int32> Indices = { Radius, 0 };
-	bool SaveLoopFlag = false;
-
-	int32 i = LoadNeighborsLoopData.IndexSaved[1];
-	std::string line;
-	while (std::getline(ifs, line))
+	const FIntPoint& Center = Tiles.AxialCoord[Index];
+	for (int32 Radius = 1; Radius <= NeighborRange; Radius++)
 	{
-		FString fline(line.c_str());
-		ParseNeighborsLine(fline, i, Radius);
-		i++;
-		Count++;
-		Indices[1] = i;
-		FlowControlUtility::SaveLoopData(this, LoadNeighborsLoopData, Count * Radius, Indices, WorkflowDelegate, SaveLoopFlag);
-		if (SaveLoopFlag) {
-			return false;
+		int32 Count = 0;
+		int32 Start = 3 * Radius * (Radius - 1);
+		for (int32 i = Start; i < Start + Radius * 6; i++)
+		{
+			if (FindTileIndex(Center + RingOffsets[i]) != INDEX_NONE) {
+				Count++;
+			}
 		}
+		//Stored one row ahead, prefix sum turns it into the end offset of the row
+		NeighborOffsets[Index * NeighborRange + Radius] = Count;
 	}
-
-	ifs.close();
-	FlowControlUtility::InitLoopData(LoadNeighborsLoopData);
-	LoadNeighborsLoopData.IndexSaved[0] = Radius;
-	UE_LOG(HexGrid, Log, TEXT("Load neighbor N%d done!"), Radius);
-	return true;
-}
-
-void AHexGrid::ParseNeighborsLine(const FString& Str, int32 Index, int32 Radius)
-{
-	ParseNeighbors(Str, Index, Radius);
 }
 
-void AHexGrid::ParseNeighbors(const FString& Str, int32 Index, int32 Radius)
+void AHexGrid::FillTileNeighbors(int32 Index)
 {
-	FStructHexTileNeighbors Neighbors;
-	Neighbors.Radius = Radius;
-	int32 Count = 0;
-	TArray<FString> StrArr;
-	Str.ParseIntoArray(StrArr, *SpaceDelim, true);
-	for (int32 i = 0; i < StrArr.Num(); i++)
+	const FIntPoint& Center = Tiles.AxialCoord[Index];
+	for (int32 Radius = 1; Radius <= NeighborRange; Radius++)
 	{
-		FIntPoint Point;
-		ParseIntPoint(StrArr[i], Point);
-		if (TileIndices.Contains(Point)) {
-			Neighbors.Tiles.Add(Point);
-			Count++;
+		int32 Write = NeighborOffsets[Index * NeighborRange + Radius - 1];
+		int32 Start = 3 * Radius * (Radius - 1);
+		for (int32 i = Start; i < Start + Radius * 6; i++)
+		{
+			int32 NeighborIndex = FindTileIndex(Center + RingOffsets[i]);
+			if (NeighborIndex != INDEX_NONE) {
+				NeighborIndices[Write++] = NeighborIndex;
+			}
 		}
 	}
-	Neighbors.Count = Count;
-	Tiles[Index].Neighbors.Add(Neighbors);
-}
-
-void AHexGrid::ParseIntPoint(const FString& Str, FIntPoint& Point)
-{
-	TArray<FString> StrArr;
-	Str.ParseIntoArray(StrArr, *CommaDelim, true);
-	Point.X = UKismetStringLibrary::Conv_StringToInt(StrArr[0]);
-	Point.Y = UKismetStringLibrary::Conv_StringToInt(StrArr[1]);
-}
-
-void AHexGrid::ParseVector2D(const FString& Str, FVector2D& Vec2D)
-{
-	TArray<FString> StrArr;
-	Str.ParseIntoArray(StrArr, *CommaDelim, true);
-	/*Vec2D.X = UKismetStringLibrary::Conv_StringToFloat(StrArr[0]);
-	Vec2D.Y = UKismetStringLibrary::Conv_StringToFloat(StrArr[1]);*/
-	LexFromString(Vec2D.X, StrArr[0]);
-	LexFromString(Vec2D.Y, StrArr[1]);
-}
-
-void AHexGrid::ParseVector(const FString& Str, FVector& Vec)
-{
-	TArray<FString> StrArr;
-	Str.ParseIntoArray(StrArr, *CommaDelim, true);
-	/*Vec.X = UKismetStringLibrary::Conv_StringToFloat(StrArr[0]);
-	Vec.Y = UKismetStringLibrary::Conv_StringToFloat(StrArr[1]);
-	Vec.Z = UKismetStringLibrary::Conv_StringToFloat(StrArr[2]);*/
-	LexFromString(Vec.X, StrArr[0]);
-	LexFromString(Vec.Y, StrArr[1]);
-	LexFromString(Vec.Z, StrArr[2]);
 }
 
-void AHexGrid::ParseInt(const FString& Str, int32& value)
+void AHexGrid::FindRingNeighbors(TArray<FIntPoint>& RingTiles, const FIntPoint& Center, int32 Radius)
 {
-	value = UKismetStringLibrary::Conv_StringToInt(Str);
+	FHexSpiral::ForEachRingPoint(Center, Radius, [&RingTiles](const FIntPoint& Coord, int32 Side, int32 Step)
+		{
+			RingTiles.Add(Coord);
+		});
 }
 
 bool AHexGrid::TilesLoopFunction(TFunction<void()> InitFunc, TFunction<void(int32 LoopIndex)> LoopFunc, 
@@ -645,70 +583,273 @@ void AHexGrid::CreateTilesVertices()
 
 void AHexGrid::InitTileVerticesVertors()
 {
-	FVector Vec(1.0, 0.0, 0.0);
-	FVector ZAxis(0.0, 0.0, 1.0);
-	for (int32 i = 0; i <= 5; i++)
-	{
-		FVector TileVector = Vec.RotateAngleAxis(i * 60, ZAxis) * TileSize;
-		TileVerticesVectors.Add(TileVector);
-	}
+	UnownedCorners.Empty();
 }
 
 void AHexGrid::CreateTileVertices(int32 Index)
 {
-	FVector Center(Tiles[Index].Position2D.X, Tiles[Index].Position2D.Y, 0);
+	//Each corner is stored once by its owner tile, other tiles reference it
+	const FIntPoint& AxialCoord = Tiles.AxialCoord[Index];
+	TStaticArray<int32, HEX_TILE_VERTEX_NUM>& VerticesCorner = Tiles.VerticesCorner[Index];
 	for (int32 i = 0; i <= 5; i++) {
-		FVector Vertex = Center + TileVerticesVectors[i];
-		Tiles[Index].VerticesPostion2D.Add(FVector2D(Vertex.X, Vertex.Y));
+		FIntPoint Owner = AxialCoord + FIntPoint(FHexTileStore::CornerOwnerQ[i], FHexTileStore::CornerOwnerR[i]);
+		int32 Slot = FHexTileStore::CornerOwnerSlot[i];
+		int32 OwnerIndex = i < HEX_TILE_OWNED_CORNER_NUM ? Index : FindTileIndex(Owner);
+		if (OwnerIndex != INDEX_NONE) {
+			VerticesCorner[i] = FHexTileStore::OwnedCorner(OwnerIndex, Slot);
+			if (OwnerIndex == Index) {
+				Tiles.CornerPosition2D[VerticesCorner[i]] = Hex::CornerPosition(FixedTileSize, AxialCoord, i);
+			}
+			continue;
+		}
+
+		FIntVector Key(Owner.X, Owner.Y, Slot);
+		int32* Corner = UnownedCorners.Find(Key);
+		VerticesCorner[i] = Corner ? *Corner : UnownedCorners.Add(Key, Tiles.AddUnownedCorner(Hex::CornerPosition(FixedTileSize, AxialCoord, i)));
 	}
 }
 
 void AHexGrid::WaitTerrain()
 {
 	FTimerHandle TimerHandle;
-	TArray<AActor*> Out_Actors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ATerrain::StaticClass(), Out_Actors);
-	if (Out_Actors.Num() == 1) {
-		Terrain = (ATerrain*)Out_Actors[0];
-		if (Terrain->IsWorkFlowStepDone(Enum_TerrainWorkflowState::InitWorkflow)) {
-			WorkflowState = Enum_HexGridWorkflowState::SetTilesPosZ;
-			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
-			UE_LOG(HexGrid, Log, TEXT("Wait terrain noise done!"));
-			return;
+	if (FindTerrain()) {
+		WorkflowState = Enum_HexGridWorkflowState::SetTilesPosZ;
+		if (bUseSnapshot) {
+			InitSnapshotKey();
+			if (LoadSnapshot()) {
+				WorkflowState = Enum_HexGridWorkflowState::AddInstances;
+			}
 		}
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		UE_LOG(HexGrid, Log, TEXT("Wait terrain noise done!"));
+		return;
 	}
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 	return;
 }
 
+void AHexGrid::InitSnapshotKey()
+{
+	uint32 Key = 0;
+	auto HashValue = [&Key](const auto& Value)
+		{
+			Key = FCrc::MemCrc32(&Value, sizeof(Value), Key);
+		};
+
+	//Dataset
+	HashValue(HEXGRID_SNAPSHOT_VERSION);
+	HashValue(CalHexGridParamsHash(TileSize, GridRange, NeighborRange));
+	HashValue(Tiles.Num());
+	for (const FIntPoint& AxialCoord : Tiles.AxialCoord)
+	{
+		HashValue(AxialCoord);
+	}
+
+	//Terrain
+	HashValue(Terrain->GetBakeParamsHash());
+	HashValue(Terrain->GetWidth());
+	HashValue(Terrain->GetHeight());
+	HashValue(Terrain->GetTileAltitudeMultiplier());
+	HashValue(Terrain->GetWaterBase());
+
+	//Tile normal is measured against mesh up vector
+	HexInstMeshUpVec = HexInstMesh->GetUpVector();
+	HashValue(HexInstMeshUpVec);
+
+	//Block
+	HashValue(AreaBlockAltitudeRatio);
+	HashValue(AreaBlockSlopeRatio);
+	HashValue(AreaBlockExTimes);
+	HashValue(BuildingBlockAltitudeRatio);
+	HashValue(BuildingBlockSlopeRatio);
+	HashValue(BuildingBlockExTimes);
+
+	SnapshotKey = Key;
+}
+
+FString AHexGrid::GetSnapshotPath()
+{
+	return FPaths::ProjectSavedDir().Append(SnapshotRelPath).Append(SnapshotFileName);
+}
+
+bool AHexGrid::LoadSnapshot()
+{
+	FString Path = GetSnapshotPath();
+	if (!FPaths::FileExists(Path)) {
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Path));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion() : nullptr);
+	if (!MappedRegion) {
+		UE_LOG(HexGrid, Warning, TEXT("Map snapshot file %s failed!"), *Path);
+		return false;
+	}
+
+	if (!ParseSnapshot(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize())) {
+		UE_LOG(HexGrid, Log, TEXT("Snapshot %s is stale or invalid, analyse tiles."), *Path);
+		return false;
+	}
+
+	UE_LOG(HexGrid, Log, TEXT("Load snapshot done!"));
+	return true;
+}
+
+bool AHexGrid::ParseSnapshot(const uint8* Data, int64 Size)
+{
+	if (Size < int64(sizeof(FHexGridSnapshotHeader))) {
+		return false;
+	}
+
+	FHexGridSnapshotHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(FHexGridSnapshotHeader));
+	if (Header.Magic != HEXGRID_SNAPSHOT_MAGIC || Header.Version != HEXGRID_SNAPSHOT_VERSION
+		|| Header.Key != SnapshotKey || Header.TileNum != Tiles.Num() || Header.CornerNum != Tiles.CornerPositionZ.Num()) {
+		return false;
+	}
+
+	//Sections must lie after the header, inside the file and on record alignment
+	if (Header.TilesOffset < int64(sizeof(FHexGridSnapshotHeader)) || Header.TilesOffset % 4 != 0
+		|| Header.TilesOffset + int64(Header.TileNum) * int64(sizeof(FHexGridSnapshotTile)) > Size
+		|| Header.CornersOffset < int64(sizeof(FHexGridSnapshotHeader)) || Header.CornersOffset % 4 != 0
+		|| Header.CornersOffset + int64(Header.CornerNum) * int64(sizeof(float)) > Size) {
+		return false;
+	}
+
+	const FHexGridSnapshotTile* Records = reinterpret_cast<const FHexGridSnapshotTile*>(Data + Header.TilesOffset);
+	ParallelFor(Tiles.Num(), [this, Records](int32 Index)
+		{
+			const FHexGridSnapshotTile& Record = Records[Index];
+			Tiles.PositionZ[Index] = Record.PositionZ;
+			Tiles.AvgPositionZ[Index] = Record.AvgPositionZ;
+			Tiles.Normal[Index] = FVector(Record.NormalX, Record.NormalY, Record.NormalZ);
+			Tiles.AngleToUp[Index] = Record.AngleToUp;
+			Tiles.TerrainAreaBlockLevel[Index] = uint8(Record.AreaBlockLevel);
+			Tiles.TerrainBuildingBlockLevel[Index] = uint8(Record.BuildingBlockLevel);
+		});
+
+	//Flags share words, set them on one thread
+	for (int32 Index = 0; Index < Tiles.Num(); Index++)
+	{
+		Tiles.TerrainIsLand[Index] = Records[Index].IsLand != 0;
+		Tiles.TerrainAreaConnection[Index] = Records[Index].AreaConnection != 0;
+	}
+
+	FMemory::Memcpy(Tiles.CornerPositionZ.GetData(), Data + Header.CornersOffset, int64(Header.CornerNum) * sizeof(float));
+
+	AreaBlockLevelMax = Header.AreaBlockLevelMax;
+	BuildingBlockLevelMax = Header.BuildingBlockLevelMax;
+	return true;
+}
+
+void AHexGrid::SaveSnapshot()
+{
+	if (bUseSnapshot) {
+		if (SaveSnapshotToFile()) {
+			UE_LOG(HexGrid, Log, TEXT("Save snapshot done!"));
+		}
+		else {
+			UE_LOG(HexGrid, Warning, TEXT("Save snapshot to %s failed!"), *GetSnapshotPath());
+		}
+	}
+
+	FTimerHandle TimerHandle;
+	WorkflowState = Enum_HexGridWorkflowState::AddInstances;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+}
+
+bool AHexGrid::SaveSnapshotToFile()
+{
+	FHexGridSnapshotHeader Header;
+	Header.Key = SnapshotKey;
+	Header.TileNum = Tiles.Num();
+	Header.AreaBlockLevelMax = AreaBlockLevelMax;
+	Header.BuildingBlockLevelMax = BuildingBlockLevelMax;
+	Header.TilesOffset = sizeof(FHexGridSnapshotHeader);
+	Header.CornerNum = Tiles.CornerPositionZ.Num();
+	Header.CornersOffset = Header.TilesOffset + int64(Tiles.Num()) * sizeof(FHexGridSnapshotTile);
+
+	TArray<FHexGridSnapshotTile> Records;
+	Records.SetNumZeroed(Tiles.Num());
+	for (int32 i = 0; i < Tiles.Num(); i++)
+	{
+		FHexGridSnapshotTile& Record = Records[i];
+		Record.PositionZ = Tiles.PositionZ[i];
+		Record.AvgPositionZ = Tiles.AvgPositionZ[i];
+		Record.NormalX = Tiles.Normal[i].X;
+		Record.NormalY = Tiles.Normal[i].Y;
+		Record.NormalZ = Tiles.Normal[i].Z;
+		Record.AngleToUp = Tiles.AngleToUp[i];
+		Record.AreaBlockLevel = Tiles.TerrainAreaBlockLevel[i];
+		Record.BuildingBlockLevel = Tiles.TerrainBuildingBlockLevel[i];
+		Record.IsLand = Tiles.TerrainIsLand[i] ? 1 : 0;
+		Record.AreaConnection = Tiles.TerrainAreaConnection[i] ? 1 : 0;
+	}
+
+	FString Path = GetSnapshotPath();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*Path));
+	if (!FileHandle) {
+		return false;
+	}
+
+	bool bWritten = FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(FHexGridSnapshotHeader))
+		&& FileHandle->Write(reinterpret_cast<const uint8*>(Records.GetData()), int64(Records.Num()) * sizeof(FHexGridSnapshotTile))
+		&& FileHandle->Write(reinterpret_cast<const uint8*>(Tiles.CornerPositionZ.GetData()), int64(Header.CornerNum) * sizeof(float));
+	FileHandle.Reset();
+	if (!bWritten) {
+		PlatformFile.DeleteFile(*Path);
+	}
+	return bWritten;
+}
+
 void AHexGrid::SetTilesPosZ()
 {
-	if (TilesLoopFunction(nullptr, [this](int32 i) { SetTilePosZ(i); },
+	if (TilesLoopFunction([this]() { InitSetTilesPosZ(); }, [this](int32 i) { SetTilePosZ(i); },
 		SetTilesPosZLoopData, Enum_HexGridWorkflowState::CalTilesNormal)) {
 		UE_LOG(HexGrid, Log, TEXT("Set tiles pos z done!"));
 	}
 }
 
+void AHexGrid::InitSetTilesPosZ()
+{
+	//Border corners without loaded owner are few, sample them up front
+	for (int32 i = Tiles.Num() * HEX_TILE_OWNED_CORNER_NUM; i < Tiles.CornerPosition2D.Num(); i++)
+	{
+		Tiles.CornerPositionZ[i] = Terrain->GetAltitudeByPos2D(Tiles.CornerPosition2D[i], this);
+	}
+	UnownedCorners.Empty();
+}
+
 void AHexGrid::SetTilePosZ(int32 Index)
 {
-	SetTileCenterPosZ(Tiles[Index]);
-	SetTileVerticesPosZ(Tiles[Index]);
+	SetTileCenterPosZ(Index);
+	SetTileCornersPosZ(Index);
+}
+
+void AHexGrid::SetTileCenterPosZ(int32 Index)
+{
+	Tiles.PositionZ[Index] = Terrain->GetAltitudeByPos2D(Tiles.Position2D[Index], this);
 }
 
-void AHexGrid::SetTileCenterPosZ(FStructHexTileData& Data)
+void AHexGrid::SetTileCornersPosZ(int32 Index)
 {
-	Data.PositionZ = Terrain->GetAltitudeByPos2D(Data.Position2D, this);
+	for (int32 Slot = 0; Slot < HEX_TILE_OWNED_CORNER_NUM; Slot++)
+	{
+		int32 Corner = FHexTileStore::OwnedCorner(Index, Slot);
+		Tiles.CornerPositionZ[Corner] = Terrain->GetAltitudeByPos2D(Tiles.CornerPosition2D[Corner], this);
+	}
 }
 
-void AHexGrid::SetTileVerticesPosZ(FStructHexTileData& Data)
+void AHexGrid::SetTileAvgPosZ(int32 Index)
 {
 	float Sum = 0.0;
-	for (int32 i = 0; i <= 5; i++) {
-		float z = Terrain->GetAltitudeByPos2D(Data.VerticesPostion2D[i], this);
-		Data.VerticesPositionZ.Add(z);
-		Sum += z;
+	for (int32 Corner : Tiles.VerticesCorner[Index]) {
+		Sum += Tiles.CornerPositionZ[Corner];
 	}
-	Data.AvgPositionZ = Sum / 6.0;
+	Tiles.AvgPositionZ[Index] = Sum / 6.0;
 }
 
 void AHexGrid::CalTilesNormal()
@@ -726,20 +867,28 @@ void AHexGrid::InitCalTilesNormal()
 
 void AHexGrid::CalTileNormal(int32 Index)
 {
-	FStructHexTileData& Data = Tiles[Index];
+	//Average corner altitude, SetTilesPosZ has finished so every corner is already sampled
+	SetTileAvgPosZ(Index);
+
+	const TStaticArray<int32, HEX_TILE_VERTEX_NUM>& VerticesCorner = Tiles.VerticesCorner[Index];
+	auto CornerVector = [this, &VerticesCorner](int32 i)
+		{
+			const FVector2D& Position2D = Tiles.CornerPosition2D[VerticesCorner[i]];
+			return FVector(Position2D.X, Position2D.Y, Tiles.CornerPositionZ[VerticesCorner[i]]);
+		};
 
 	FVector TileNormal(0, 0, 0);
 	for (int32 i = 0; i < 2; i++) {
-		FVector v0(Data.VerticesPostion2D[i].X, Data.VerticesPostion2D[i].Y, Data.VerticesPositionZ[i]);
-		FVector v1(Data.VerticesPostion2D[2 + i].X, Data.VerticesPostion2D[2 + i].Y, Data.VerticesPositionZ[2 + i]);
-		FVector v2(Data.VerticesPostion2D[4 + i].X, Data.VerticesPostion2D[4 + i].Y, Data.VerticesPositionZ[4 + i]);
+		FVector v0 = CornerVector(i);
+		FVector v1 = CornerVector(2 + i);
+		FVector v2 = CornerVector(4 + i);
 		TileNormal += FVector::CrossProduct(v2 - v0, v2 - v1);
 	}
 	TileNormal.Normalize();
-	Data.Normal = TileNormal;
+	Tiles.Normal[Index] = TileNormal;
 
 	float DotProduct = FVector::DotProduct(HexInstMeshUpVec, TileNormal);
-	Data.AngleToUp = acosf(DotProduct);
+	Tiles.AngleToUp[Index] = acosf(DotProduct);
 }
 
 void AHexGrid::SetTilesAreaBlockLevel()
@@ -755,13 +904,13 @@ void AHexGrid::InitSetTilesAreaBlockLevel()
 	AreaBlockLevelMax = NeighborRange + 1;
 }
 
-bool AHexGrid::SetTileAreaBlock(FStructHexTileData& Data, FStructHexTileData& CheckData, int32 BlockLevel)
+bool AHexGrid::SetTileAreaBlock(int32 Index, int32 CheckIndex, int32 BlockLevel)
 {
-	if (!IsInMapRange(CheckData)
-		|| CheckData.AvgPositionZ > AreaBlockAltitudeRatio * Terrain->GetTileAltitudeMultiplier()
-		|| CheckData.AvgPositionZ < Terrain->GetWaterBase()
-		|| CheckData.AngleToUp >(PI * AreaBlockSlopeRatio / 2.0)) {
-		Data.TerrainAreaBlockLevel = BlockLevel;
+	if (!IsInMapRange(CheckIndex)
+		|| Tiles.AvgPositionZ[CheckIndex] > AreaBlockAltitudeRatio * Terrain->GetTileAltitudeMultiplier()
+		|| Tiles.AvgPositionZ[CheckIndex] < Terrain->GetWaterBase()
+		|| Tiles.AngleToUp[CheckIndex] >(PI * AreaBlockSlopeRatio / 2.0)) {
+		Tiles.TerrainAreaBlockLevel[Index] = uint8(BlockLevel);
 		return true;
 	}
 	return false;
@@ -769,36 +918,27 @@ bool AHexGrid::SetTileAreaBlock(FStructHexTileData& Data, FStructHexTileData& Ch
 
 void AHexGrid::SetTileAreaBlockLevelByNeighbors(int32 Index)
 {
-	FStructHexTileData& Data = Tiles[Index];
-	if (SetTileAreaBlock(Data, Data, 0)) {
+	if (SetTileAreaBlock(Index, Index, 0)) {
 		return;
 	}
 
-	for (int32 i = 0; i < Data.Neighbors.Num(); i++)
+	for (int32 Radius = 1; Radius <= NeighborRange; Radius++)
 	{
-		if (SetTileAreaBlockLevelByNeighbor(Data, i)) {
+		if (SetTileAreaBlockLevelByNeighbor(Index, Radius)) {
 			return;
 		}
 	}
-	Data.TerrainAreaBlockLevel = AreaBlockLevelMax;
-	if (Data.TerrainAreaBlockLevel == (NeighborRange * (AreaBlockExTimes + 1) + 1)) {
+	Tiles.TerrainAreaBlockLevel[Index] = uint8(AreaBlockLevelMax);
+	if (Tiles.TerrainAreaBlockLevel[Index] == (NeighborRange * (AreaBlockExTimes + 1) + 1)) {
 		MaxAreaBlockTileIndices.Add(Index);
 	}
 }
 
-bool AHexGrid::SetTileAreaBlockLevelByNeighbor(FStructHexTileData& Data, int32 Index)
+bool AHexGrid::SetTileAreaBlockLevelByNeighbor(int32 Index, int32 Radius)
 {
-	FStructHexTileNeighbors Neighbors = Data.Neighbors[Index];
-	int32 TileIndex;
-	for (int32 i = 0; i < Neighbors.Tiles.Num(); i++)
+	for (int32 NeighborIndex : GetTileNeighbors(Index, Radius))
 	{
-		FIntPoint key = Neighbors.Tiles[i];
-		if (!TileIndices.Contains(key)) {
-			continue;
-		}
-
-		TileIndex = TileIndices[key];
-		if (SetTileAreaBlock(Data, Tiles[TileIndex], Neighbors.Radius))
+		if (SetTileAreaBlock(Index, NeighborIndex, Radius))
 		{
 			return true;
 		}
@@ -842,21 +982,19 @@ void AHexGrid::InitSetTilesAreaBlockLevelEx()
 
 void AHexGrid::SetTileAreaBlockLevelByNeighborsEx(int32 Index)
 {
-	FStructHexTileData& Data = Tiles[Index];
-
-	if (Data.TerrainAreaBlockLevel == (AreaBlockLevelMax - NeighborRange)) {
-		FStructHexTileNeighbors OutSideNeighbors = Data.Neighbors[Data.Neighbors.Num() - 1];
+	uint8& BlockLevel = Tiles.TerrainAreaBlockLevel[Index];
+	if (BlockLevel == (AreaBlockLevelMax - NeighborRange)) {
 		int32 BlockLvMin = AreaBlockLevelMax;
-		int32 CurrentBlockLv = Data.TerrainAreaBlockLevel;
-		for (int32 i = 0; i < OutSideNeighbors.Count; i++)
+		int32 CurrentBlockLv = BlockLevel;
+		for (int32 NeighborIndex : GetTileNeighbors(Index, NeighborRange))
 		{
-			CurrentBlockLv = NeighborRange + Tiles[TileIndices[OutSideNeighbors.Tiles[i]]].TerrainAreaBlockLevel;
+			CurrentBlockLv = NeighborRange + Tiles.TerrainAreaBlockLevel[NeighborIndex];
 			if (CurrentBlockLv < BlockLvMin) {
 				BlockLvMin = CurrentBlockLv;
 			}
 		}
-		Data.TerrainAreaBlockLevel = BlockLvMin;
-		if (Data.TerrainAreaBlockLevel == (NeighborRange * (AreaBlockExTimes + 1) + 1)) {
+		BlockLevel = uint8(BlockLvMin);
+		if (BlockLevel == (NeighborRange * (AreaBlockExTimes + 1) + 1)) {
 			MaxAreaBlockTileIndices.Add(Index);
 		}
 	}
@@ -917,17 +1055,12 @@ void AHexGrid::BreakMaxAreaBlockTilesToChunk()
 			int32 current;
 			CheckAreaConnectionFrontier.Dequeue(current);
 
-			FStructHexTileNeighbors Neighbors = Tiles[current].Neighbors[0];
-			for (int32 i = 0; i < Neighbors.Tiles.Num(); i++) {
-				FIntPoint key = Neighbors.Tiles[i];
-				if (!TileIndices.Contains(key)) {
-					continue;
-				}
-				if (!CheckAreaConnectionReached.Contains(TileIndices[key])
-					&& MaxAreaBlockTileIndices.Contains(TileIndices[key])) {
-					CheckAreaConnectionFrontier.Enqueue(TileIndices[key]);
-					CheckAreaConnectionReached.Add(TileIndices[key]);
-					MaxAreaBlockTileIndices.Remove(TileIndices[key]);
+			for (int32 NeighborIndex : GetTileNeighbors(current, 1)) {
+				if (!CheckAreaConnectionReached.Contains(NeighborIndex)
+					&& MaxAreaBlockTileIndices.Contains(NeighborIndex)) {
+					CheckAreaConnectionFrontier.Enqueue(NeighborIndex);
+					CheckAreaConnectionReached.Add(NeighborIndex);
+					MaxAreaBlockTileIndices.Remove(NeighborIndex);
 				}
 			}
 
@@ -988,16 +1121,11 @@ bool AHexGrid::FindTwoChunksAreaConnection(TSet<int32>& ChunkStart, TSet<int32>&
 		if (ChunkObj.Contains(current)) {
 			return true;
 		}
-		FStructHexTileNeighbors Neighbors = Tiles[current].Neighbors[0];
-		for (int32 i = 0; i < Neighbors.Tiles.Num(); i++) {
-			FIntPoint key = Neighbors.Tiles[i];
-			if (!TileIndices.Contains(key)) {
-				continue;
-			}
-			if (!reached.Contains(TileIndices[key])
-				&& Tiles[TileIndices[key]].TerrainAreaBlockLevel >= 3) {
-				frontier.Enqueue(TileIndices[key]);
-				reached.Add(TileIndices[key]);
+		for (int32 NeighborIndex : GetTileNeighbors(current, 1)) {
+			if (!reached.Contains(NeighborIndex)
+				&& Tiles.TerrainAreaBlockLevel[NeighborIndex] >= 3) {
+				frontier.Enqueue(NeighborIndex);
+				reached.Add(NeighborIndex);
 			}
 		}
 	}
@@ -1009,7 +1137,7 @@ void AHexGrid::CheckTerrainAreaConnectionNotPass(int32 ChunkIndex)
 	TSet<int32> Cks = MaxAreaBlockTileChunks[ChunkIndex];
 	TArray<int32> CksArray = Cks.Array();
 	for (int32 i : CksArray) {
-		Tiles[i].TerrainAreaConnection = false;
+		Tiles.TerrainAreaConnection[i] = false;
 	}
 }
 
@@ -1023,42 +1151,38 @@ void AHexGrid::FindTilesIsland()
 
 void AHexGrid::FindTileIsLand(int32 Index)
 {
-	FStructHexTileData& Data = Tiles[Index];
-	if (Data.TerrainAreaBlockLevel == AreaBlockLevelMax) {
-		if (Data.TerrainAreaConnection) {
-			Data.TerrainIsLand = false;
+	uint8& BlockLevel = Tiles.TerrainAreaBlockLevel[Index];
+	FBitReference IsLand = Tiles.TerrainIsLand[Index];
+	if (BlockLevel == AreaBlockLevelMax) {
+		if (Tiles.TerrainAreaConnection[Index]) {
+			IsLand = false;
 		}
 		else {
-			Data.TerrainIsLand = true;
+			IsLand = true;
 		}
 
 	}
-	else if (Data.TerrainAreaBlockLevel < AreaBlockLevelMax && Data.TerrainAreaBlockLevel >= 3) {
-		Data.TerrainIsLand = !Find_ABLM_By_ABL3(Index);
+	else if (BlockLevel < AreaBlockLevelMax && BlockLevel >= 3) {
+		IsLand = !Find_ABLM_By_ABL3(Index);
 	}
-	else if (Data.TerrainAreaBlockLevel < 3 && Data.TerrainAreaBlockLevel >= 1) {
-		for (int32 i = Data.TerrainAreaBlockLevel; i > 0; i--) {
-			FStructHexTileNeighbors Neighbors = Data.Neighbors[2 - i];
-			for (int32 j = 0; j < Neighbors.Tiles.Num(); j++) {
-				FIntPoint key = Neighbors.Tiles[j];
-				if (!TileIndices.Contains(key)) {
-					continue;
-				}
-				if (Tiles[TileIndices[key]].TerrainAreaBlockLevel == 3) {
-					if (Find_ABLM_By_ABL3(TileIndices[key])) {
-						Data.TerrainIsLand = false;
-						if (i < Data.TerrainAreaBlockLevel) {
-							Data.TerrainAreaBlockLevel = i;
+	else if (BlockLevel < 3 && BlockLevel >= 1) {
+		for (int32 i = BlockLevel; i > 0; i--) {
+			for (int32 NeighborIndex : GetTileNeighbors(Index, 3 - i)) {
+				if (Tiles.TerrainAreaBlockLevel[NeighborIndex] == 3) {
+					if (Find_ABLM_By_ABL3(NeighborIndex)) {
+						IsLand = false;
+						if (i < BlockLevel) {
+							BlockLevel = uint8(i);
 						}
 						return;
 					}
 				}
 			}
 		}
-		Data.TerrainIsLand = true;
+		IsLand = true;
 	}
 	else {
-		Data.TerrainIsLand = true;
+		IsLand = true;
 	}
 }
 
@@ -1074,8 +1198,8 @@ bool AHexGrid::Find_ABLM_By_ABL3(int32 Index)
 	{
 		int32 current;
 		frontier.Dequeue(current);
-		if (Tiles[current].TerrainAreaBlockLevel == AreaBlockLevelMax) {
-			if (Tiles[current].TerrainAreaConnection) {
+		if (Tiles.TerrainAreaBlockLevel[current] == AreaBlockLevelMax) {
+			if (Tiles.TerrainAreaConnection[current]) {
 				return true;
 			}
 			else {
@@ -1083,15 +1207,10 @@ bool AHexGrid::Find_ABLM_By_ABL3(int32 Index)
 			}
 		}
 
-		FStructHexTileNeighbors Neighbors = Tiles[current].Neighbors[0];
-		for (int32 i = 0; i < Neighbors.Tiles.Num(); i++) {
-			FIntPoint key = Neighbors.Tiles[i];
-			if (!TileIndices.Contains(key)) {
-				continue;
-			}
-			if (!reached.Contains(TileIndices[key]) && Tiles[TileIndices[key]].TerrainAreaBlockLevel >= 3) {
-				frontier.Enqueue(TileIndices[key]);
-				reached.Add(TileIndices[key]);
+		for (int32 NeighborIndex : GetTileNeighbors(current, 1)) {
+			if (!reached.Contains(NeighborIndex) && Tiles.TerrainAreaBlockLevel[NeighborIndex] >= 3) {
+				frontier.Enqueue(NeighborIndex);
+				reached.Add(NeighborIndex);
 			}
 		}
 	}
@@ -1113,13 +1232,13 @@ void AHexGrid::InitSetTilesBuildingBlockLevel()
 	BuildingBlockSlopeRatio = BuildingBlockSlopeRatio > AreaBlockSlopeRatio ? AreaBlockSlopeRatio : BuildingBlockSlopeRatio;
 }
 
-bool AHexGrid::SetTileBuildingBlock(FStructHexTileData& Data, FStructHexTileData& CheckData, int32 BuildingBlockLevel)
+bool AHexGrid::SetTileBuildingBlock(int32 Index, int32 CheckIndex, int32 BuildingBlockLevel)
 {
-	if (!IsInMapRange(CheckData)
-		|| CheckData.AvgPositionZ > BuildingBlockAltitudeRatio * Terrain->GetTileAltitudeMultiplier()
-		|| CheckData.AvgPositionZ < Terrain->GetWaterBase()
-		|| CheckData.AngleToUp >(PI * BuildingBlockSlopeRatio / 2.0)) {
-		Data.TerrainBuildingBlockLevel = BuildingBlockLevel;
+	if (!IsInMapRange(CheckIndex)
+		|| Tiles.AvgPositionZ[CheckIndex] > BuildingBlockAltitudeRatio * Terrain->GetTileAltitudeMultiplier()
+		|| Tiles.AvgPositionZ[CheckIndex] < Terrain->GetWaterBase()
+		|| Tiles.AngleToUp[CheckIndex] >(PI * BuildingBlockSlopeRatio / 2.0)) {
+		Tiles.TerrainBuildingBlockLevel[Index] = uint8(BuildingBlockLevel);
 		return true;
 	}
 	return false;
@@ -1127,33 +1246,24 @@ bool AHexGrid::SetTileBuildingBlock(FStructHexTileData& Data, FStructHexTileData
 
 void AHexGrid::SetTileBuildingBlockLevelByNeighbors(int32 Index)
 {
-	FStructHexTileData& Data = Tiles[Index];
-	if (SetTileBuildingBlock(Data, Data, 0)) {
+	if (SetTileBuildingBlock(Index, Index, 0)) {
 		return;
 	}
 
-	for (int32 i = 0; i < Data.Neighbors.Num(); i++)
+	for (int32 Radius = 1; Radius <= NeighborRange; Radius++)
 	{
-		if (SetTileBuildingBlockLevelByNeighbor(Data, i)) {
+		if (SetTileBuildingBlockLevelByNeighbor(Index, Radius)) {
 			return;
 		}
 	}
-	Data.TerrainBuildingBlockLevel = BuildingBlockLevelMax;
+	Tiles.TerrainBuildingBlockLevel[Index] = uint8(BuildingBlockLevelMax);
 }
 
-bool AHexGrid::SetTileBuildingBlockLevelByNeighbor(FStructHexTileData& Data, int32 Index)
+bool AHexGrid::SetTileBuildingBlockLevelByNeighbor(int32 Index, int32 Radius)
 {
-	FStructHexTileNeighbors Neighbors = Data.Neighbors[Index];
-	int32 TileIndex;
-	for (int32 i = 0; i < Neighbors.Tiles.Num(); i++)
+	for (int32 NeighborIndex : GetTileNeighbors(Index, Radius))
 	{
-		FIntPoint key = Neighbors.Tiles[i];
-		if (!TileIndices.Contains(key)) {
-			continue;
-		}
-
-		TileIndex = TileIndices[key];
-		if (SetTileBuildingBlock(Data, Tiles[TileIndex], Neighbors.Radius))
+		if (SetTileBuildingBlock(Index, NeighborIndex, Radius))
 		{
 			return true;
 		}
@@ -1166,7 +1276,7 @@ void AHexGrid::SetTilesBuildingBlockLevelEx()
 {
 	if (BuildingBlockExTimes == 0) {
 		FTimerHandle TimerHandle;
-		WorkflowState = Enum_HexGridWorkflowState::AddInstances;
+		WorkflowState = Enum_HexGridWorkflowState::SaveSnapshot;
 		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 		UE_LOG(HexGrid, Log, TEXT("Set tiles Building block level extension done!"));
 		return;
@@ -1177,7 +1287,7 @@ void AHexGrid::SetTilesBuildingBlockLevelEx()
 	for (; i < BuildingBlockExTimes; i++) {
 		SetTilesBuildingBlockLevelExLoopData.IndexSaved[0] = i;
 		if (i == (BuildingBlockExTimes - 1)) {
-			state = Enum_HexGridWorkflowState::AddInstances;
+			state = Enum_HexGridWorkflowState::SaveSnapshot;
 		}
 		if (TilesLoopFunction([this]() { InitSetTilesBuildingBlockExLevel(); }, [this](int32 i) { SetTileBuildingBlockLevelByNeighborsEx(i); },
 			BuildingBlockLevelExLoopDatas[i], state)) {
@@ -1196,19 +1306,18 @@ void AHexGrid::InitSetTilesBuildingBlockExLevel()
 
 void AHexGrid::SetTileBuildingBlockLevelByNeighborsEx(int32 Index)
 {
-	FStructHexTileData& Data = Tiles[Index];
-	if (Data.TerrainBuildingBlockLevel == (BuildingBlockLevelMax - NeighborRange)) {
-		FStructHexTileNeighbors OutSideNeighbors = Data.Neighbors[Data.Neighbors.Num() - 1];
+	uint8& BuildingBlockLevel = Tiles.TerrainBuildingBlockLevel[Index];
+	if (BuildingBlockLevel == (BuildingBlockLevelMax - NeighborRange)) {
 		int32 BuildingBlockLvMin = BuildingBlockLevelMax;
-		int32 CurrentBuildingBlockLv = Data.TerrainBuildingBlockLevel;
-		for (int32 i = 0; i < OutSideNeighbors.Count; i++)
+		int32 CurrentBuildingBlockLv = BuildingBlockLevel;
+		for (int32 NeighborIndex : GetTileNeighbors(Index, NeighborRange))
 		{
-			CurrentBuildingBlockLv = NeighborRange + Tiles[TileIndices[OutSideNeighbors.Tiles[i]]].TerrainBuildingBlockLevel;
+			CurrentBuildingBlockLv = NeighborRange + Tiles.TerrainBuildingBlockLevel[NeighborIndex];
 			if (CurrentBuildingBlockLv < BuildingBlockLvMin) {
 				BuildingBlockLvMin = CurrentBuildingBlockLv;
 			}
 		}
-		Data.TerrainBuildingBlockLevel = BuildingBlockLvMin;
+		BuildingBlockLevel = uint8(BuildingBlockLvMin);
 	}
 }
 
@@ -1233,6 +1342,27 @@ void AHexGrid::InitAddTilesInstance()
 {
 	HexInstMesh->NumCustomDataFloats = 3;
 	HexInstanceScale = TileSize / HexInstMeshSize;
+	UpdateChunksStats();
+}
+
+void AHexGrid::UpdateChunksStats()
+{
+	//Tile state is final here, analysed or restored from snapshot
+	ParallelFor(Chunks.Num(), [this](int32 ChunkIndex)
+		{
+			FHexGridChunk& Chunk = Chunks[ChunkIndex];
+			Chunk.MinPositionZ = TNumericLimits<float>::Max();
+			Chunk.MaxPositionZ = TNumericLimits<float>::Lowest();
+			Chunk.MaxAreaBlockLevel = 0;
+			Chunk.MaxBuildingBlockLevel = 0;
+			for (int32 Index : Chunk.TileIndices)
+			{
+				Chunk.MinPositionZ = FMath::Min(Chunk.MinPositionZ, Tiles.AvgPositionZ[Index]);
+				Chunk.MaxPositionZ = FMath::Max(Chunk.MaxPositionZ, Tiles.AvgPositionZ[Index]);
+				Chunk.MaxAreaBlockLevel = FMath::Max(Chunk.MaxAreaBlockLevel, int32(Tiles.TerrainAreaBlockLevel[Index]));
+				Chunk.MaxBuildingBlockLevel = FMath::Max(Chunk.MaxBuildingBlockLevel, int32(Tiles.TerrainBuildingBlockLevel[Index]));
+			}
+		});
 }
 
 int32 AHexGrid::AddTileInstance(int32 Index)
@@ -1246,14 +1376,14 @@ int32 AHexGrid::AddISM(int32 Index, UInstancedStaticMeshComponent* ISM, float ZO
 		return -1;
 	}
 
-	FStructHexTileData tile = Tiles[Index];
-	FVector HexLoc(tile.Position2D.X, tile.Position2D.Y, tile.AvgPositionZ + ZOffset);
+	const FVector2D& Position2D = Tiles.Position2D[Index];
+	FVector HexLoc(Position2D.X, Position2D.Y, Tiles.AvgPositionZ[Index] + ZOffset);
 	FVector HexScale(HexInstanceScale);
 
-	FVector RotationAxis = FVector::CrossProduct(HexInstMeshUpVec, tile.Normal);
+	FVector RotationAxis = FVector::CrossProduct(HexInstMeshUpVec, Tiles.Normal[Index]);
 	RotationAxis.Normalize();
 
-	FQuat Quat = FQuat(RotationAxis, tile.AngleToUp);
+	FQuat Quat = FQuat(RotationAxis, Tiles.AngleToUp[Index]);
 	FQuat NewQuat = Quat * HexInstMeshRot.Quaternion();
 
 	FTransform HexTransform(NewQuat.Rotator(), HexLoc, HexScale);
@@ -1287,16 +1417,16 @@ void AHexGrid::AddTileInstanceData(int32 TileIndex, int32 InstanceIndex)
 {
 	float H = 0.0;
 	if (GridShowMode == Enum_BlockMode::AreaBlock) {
-		if (!Tiles[TileIndex].TerrainIsLand) {
-			H = 120.0f / float(AreaBlockLevelMax) * float(Tiles[TileIndex].TerrainAreaBlockLevel);
+		if (!Tiles.TerrainIsLand[TileIndex]) {
+			H = 120.0f / float(AreaBlockLevelMax) * float(Tiles.TerrainAreaBlockLevel[TileIndex]);
 		}
 		else {
 			H = 240.0;
 		}
 	}
 	else if (GridShowMode == Enum_BlockMode::BuildingBlock) {
-		if (!Tiles[TileIndex].TerrainIsLand) {
-			H = 120.0f / float(BuildingBlockLevelMax) * float(Tiles[TileIndex].TerrainBuildingBlockLevel);
+		if (!Tiles.TerrainIsLand[TileIndex]) {
+			H = 120.0f / float(BuildingBlockLevelMax) * float(Tiles.TerrainBuildingBlockLevel[TileIndex]);
 		}
 		else {
 			H = 240.0;
@@ -1311,13 +1441,45 @@ void AHexGrid::AddTileInstanceData(int32 TileIndex, int32 InstanceIndex)
 
 bool AHexGrid::IsInMapRange(int32 Index)
 {
-	return IsInMapRange(Tiles[Index]);
+	const FVector2D& Position2D = Tiles.Position2D[Index];
+	return (FMath::Abs<float>(Position2D.X) < Terrain->GetWidth() / 2
+		&& FMath::Abs<float>(Position2D.Y) < Terrain->GetHeight() / 2);
 }
 
-bool AHexGrid::IsInMapRange(const FStructHexTileData& Tile)
+void AHexGrid::FindBuildableTiles(int32 MinBuildingBlockLevel, TArray<int32>& OutTileIndices) const
 {
-	return (FMath::Abs<float>(Tile.Position2D.X) < Terrain->GetWidth() / 2
-		&& FMath::Abs<float>(Tile.Position2D.Y) < Terrain->GetHeight() / 2);
+	TBitArray<> Mask;
+	Tiles.FindBuildableTiles(MinBuildingBlockLevel, Mask);
+	OutTileIndices.Reset(Mask.CountSetBits());
+	for (TConstSetBitIterator<> It(Mask); It; ++It)
+	{
+		OutTileIndices.Add(It.GetIndex());
+	}
+}
+
+void AHexGrid::FindTilesInBox(const FBox2D& Box, TArray<int32>& OutTileIndices) const
+{
+	OutTileIndices.Reset();
+	for (const FHexGridChunk& Chunk : Chunks)
+	{
+		if (!Box.Intersect(Chunk.Bounds)) {
+			continue;
+		}
+		for (int32 Index : Chunk.TileIndices)
+		{
+			if (Box.IsInside(Tiles.Position2D[Index])) {
+				OutTileIndices.Add(Index);
+			}
+		}
+	}
+}
+
+FStructHexTileData AHexGrid::GetTileData(int32 Index) const
+{
+	if (!Tiles.IsValidIndex(Index)) {
+		return FStructHexTileData();
+	}
+	return Tiles.GetTileData(Index);
 }
 
 // Called every frame
@@ -1333,86 +1495,35 @@ void AHexGrid::MouseOverGrid(const FVector2D& MousePos)
 		return;
 	}
 
-	Hex hex = Hex::PosToHex(MousePos, TileSize);
-	MouseOverHex.SetHex(hex);
+	MouseOverHex = Hex::PosToHex(MousePos, FixedTileSize);
 	RemoveMouseOverTilesInstance();
 	AddMouseOverTilesInstance();
 }
 
-Hex AHexGrid::PosToHex(const FVector2D& Point, float Size)
-{
-	float q = (2.0 / 3.0 * Point.X) / Size;
-	float r = (-1.0 / 3.0 * Point.X + FMath::Sqrt(3.0) / 3.0 * Point.Y) / Size;
-
-	float qfz = FMath::RoundFromZero(q);
-	float rfz = FMath::RoundFromZero(r);
-	float qtz = FMath::RoundToZero(q);
-	float rtz = FMath::RoundToZero(r);
-
-	Hex hex1(FVector2D(qfz, rfz));
-	Hex hex2(FVector2D(qfz, rtz));
-	Hex hex3(FVector2D(qtz, rfz));
-	Hex hex4(FVector2D(qtz, rtz));
-
-	int32 index1 = TileIndices[hex1.ToIntPoint()];
-	int32 index2 = TileIndices[hex2.ToIntPoint()];
-	int32 index3 = TileIndices[hex3.ToIntPoint()];
-	int32 index4 = TileIndices[hex4.ToIntPoint()];
-
-	FVector2D center1 = Tiles[index1].Position2D;
-	FVector2D center2 = Tiles[index2].Position2D;
-	FVector2D center3 = Tiles[index3].Position2D;
-	FVector2D center4 = Tiles[index4].Position2D;
-
-	float dist1 = FVector2D::Distance(Point, center1);
-	float dist2 = FVector2D::Distance(Point, center2);
-	float dist3 = FVector2D::Distance(Point, center3);
-	float dist4 = FVector2D::Distance(Point, center4);
-
-	Hex OutHex;
-	if (dist1 < dist2 && dist1 < dist3 && dist1 < dist4) {
-		OutHex.SetHex(hex1);
-	}
-	else if (dist2 < dist3 && dist2 < dist4) {
-		OutHex.SetHex(hex2);
-	}
-	else if (dist3 < dist4) {
-		OutHex.SetHex(hex3);
-	}
-	else {
-		OutHex.SetHex(hex4);
-	}
-	return OutHex;
-}
-
 void AHexGrid::FindNeighborTilesByRadius(TArray<FIntPoint>& NeighborTiles, int32 CenterIndex, int32 Radius)
 {
-	Hex center(Tiles[CenterIndex].AxialCoord);
-	Hex Current;
-	for (int32 i = 1; i <= MouseOverShowRadius; i++) 
+	for (int32 i = 1; i <= Radius; i++)
 	{
-		Current.SetHex(Hex::Add(Hex::Scale(Hex::Direction(RING_START_DIRECTION_INDEX), i), center));
-		for (int32 j = 0; j <= 5; j++) 
-		{
-			for (int32 k = 0; k <= i - 1; k++)
-			{
-				NeighborTiles.Add(Current.ToIntPoint());
-				Current.SetHex(Hex::Neighbor(Current, j));
-			}
-		}
+		FindRingNeighbors(NeighborTiles, Tiles.AxialCoord[CenterIndex], i);
 	}
 }
 
 void AHexGrid::AddMouseOverTilesInstance()
 {
-	int32 Index = TileIndices[MouseOverHex.ToIntPoint()];
+	int32 Index = FindTileIndex(MouseOverHex.ToIntPoint());
+	if (Index == INDEX_NONE) {
+		return;
+	}
 	int32 InstanceIndex = AddISM(Index, MouseOverInstMesh, MouseOverInstMeshOffsetZ);
 
 	TArray<FIntPoint> NeighborTiles;
 	FindNeighborTilesByRadius(NeighborTiles, Index, MouseOverShowRadius);
 	for (int32 i = 0; i < NeighborTiles.Num(); i++)
 	{
-		AddISM(TileIndices[NeighborTiles[i]], MouseOverInstMesh, MouseOverInstMeshOffsetZ);
+		int32 NeighborIndex = FindTileIndex(NeighborTiles[i]);
+		if (NeighborIndex != INDEX_NONE) {
+			AddISM(NeighborIndex, MouseOverInstMesh, MouseOverInstMeshOffsetZ);
+		}
 	}
 
 }
@@ -1,12 +1,11 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "HexGridCreator.h"
+#include "Hex.h"
+#include "HexSpiral.h"
 #include "FlowControlUtility.h"
 
-#include <filesystem>
-#include <iostream>
-#include <fstream>
-#include <Kismet/KismetTextLibrary.h>
+#include <Async/ParallelFor.h>
 
 DEFINE_LOG_CATEGORY(HexGridCreator);
 
@@ -18,12 +17,125 @@ void AHexGridCreator::CreateData()
 {
 	if (IsInWorkingState()) return;
 
+	if (!bForceRecreate && IsCachedDataValid()) {
+		UE_LOG(HexGridCreator, Log, TEXT("HexGrid data is up to date, skip creating."));
+		return;
+	}
+
 	UE_LOG(HexGridCreator, Log, TEXT("AHexGridCreator::CreateData()."));
+	if (!InitResume()) {
+		InitIncrementalWrite();
+	}
+	InvalidateParams(DataFileRelPath + ParamsDataFileName);
 	BindDelegate();
 	WorkflowState = Enum_HexGridCreatorWorkflowState::InitWorkflow;
 	CreateHexGridFlow();
 }
 
+bool AHexGridCreator::IsCachedDataValid()
+{
+	TArray<FString> DataRelPaths = { DataFileRelPath + TilesDataFileName };
+	if (bWriteBinaryData) {
+		DataRelPaths.Add(DataFileRelPath + BinaryDataFileName);
+	}
+	return IsDataUpToDate(DataFileRelPath + ParamsDataFileName, DataRelPaths,
+		CalHexGridParamsHash(TileSize, GridRange, NeighborRange));
+}
+
+void AHexGridCreator::InitIncrementalWrite()
+{
+	//Spiral order makes a larger grid a prefix extension of a smaller one, and neighbors
+	//are not stored, so only new rings are appended to text data when TileSize is unchanged
+	TextTileBegin = 0;
+	if (bForceRecreate) {
+		return;
+	}
+
+	TArray<FString> OldParams;
+	uint32 OldHash;
+	float OldTileSize;
+	int32 OldGridRange, OldNeighborRange;
+	if (!ReadParams(DataFileRelPath + ParamsDataFileName, OldParams, OldHash) || OldParams.Num() != 3
+		|| !LexTryParseString(OldTileSize, *OldParams[0])
+		|| !LexTryParseString(OldGridRange, *OldParams[1])
+		|| !LexTryParseString(OldNeighborRange, *OldParams[2])) {
+		return;
+	}
+
+	//Hash also covers data version, old files written in another format are rewritten
+	if (OldHash != CalHexGridParamsHash(OldTileSize, OldGridRange, OldNeighborRange)
+		|| FMath::RoundHalfFromZero(double(OldTileSize) * 100.0) != FMath::RoundHalfFromZero(double(TileSize) * 100.0)
+		|| OldGridRange <= 0 || OldGridRange > GridRange) {
+		return;
+	}
+
+	if (!CanAppendDataFile(DataFileRelPath + TilesDataFileName)) {
+		return;
+	}
+
+	TextTileBegin = FHexSpiral::TileNum(OldGridRange);
+	UE_LOG(HexGridCreator, Log, TEXT("Reuse %d tiles of GridRange %d, append rings %d to %d."),
+		TextTileBegin, OldGridRange, OldGridRange + 1, GridRange);
+}
+
+bool AHexGridCreator::InitResume()
+{
+	FString CheckpointRelPath = DataFileRelPath + CheckpointFileName;
+	if (bForceRecreate || !LoadCheckpoint(CheckpointRelPath, CalHexGridParamsHash(TileSize, GridRange, NeighborRange))
+		|| Checkpoint.Values.Num() != 1 || Checkpoint.LoopIndices.Num() != 1
+		|| Checkpoint.Stage != int32(Enum_HexGridCreatorWorkflowState::WriteTiles)) {
+		DeleteCheckpoint(CheckpointRelPath);
+		return false;
+	}
+
+	//Text files keep the same begin tile as the interrupted run
+	TextTileBegin = Checkpoint.Values[0];
+	return true;
+}
+
+void AHexGridCreator::ResumeLoopData(Enum_HexGridCreatorWorkflowState Stage, FStructLoopData& LoopData)
+{
+	if (bResumeCheckpoint && Checkpoint.Stage == int32(Stage)) {
+		LoopData.IndexSaved[0] = Checkpoint.LoopIndices[0];
+		LoopData.Count = Checkpoint.LoopCount;
+	}
+}
+
+bool AHexGridCreator::OpenStageWriter(Enum_HexGridCreatorWorkflowState Stage, FStructLoopData& LoopData, const FString& RelPath, const FString& FullPath)
+{
+	if (bResumeCheckpoint && Checkpoint.Stage == int32(Stage)) {
+		bResumeCheckpoint = false;
+		if (ResumeDataWriter(DataWriter, FullPath, Checkpoint.FindFileSize(RelPath))) {
+			return true;
+		}
+
+		//Same as an unusable checkpoint, but the file tail is unknown now, so write it from the first tile
+		UE_LOG(HexGridCreator, Warning, TEXT("Resume file %s failed, write it from the beginning."), *FullPath);
+		DeleteCheckpoint(DataFileRelPath + CheckpointFileName);
+		TextTileBegin = 0;
+		LoopData.IndexSaved[0] = TextTileBegin;
+		LoopData.Count = 0;
+	}
+	return OpenDataWriter(FullPath, true, TextTileBegin > 0);
+}
+
+void AHexGridCreator::SaveWriteCheckpoint(Enum_HexGridCreatorWorkflowState Stage, const FStructLoopData& LoopData, const FString& RelPath)
+{
+	if (!IsCheckpointDue() || !DataWriter.Flush()) {
+		return;
+	}
+
+	FDataCreatorCheckpoint Data;
+	Data.ParamsHash = CalHexGridParamsHash(TileSize, GridRange, NeighborRange);
+	Data.Stage = int32(Stage);
+	Data.LoopCount = LoopData.Count;
+	Data.LoopIndices.Add(LoopData.IndexSaved[0]);
+	Data.Values.Add(TextTileBegin);
+	Data.FileRelPaths.Add(RelPath);
+	Data.FileSizes.Add(DataWriter.Tell());
+	SaveCheckpoint(DataFileRelPath + CheckpointFileName, Data);
+}
+
 void AHexGridCreator::BindDelegate()
 {
 	WorkflowDelegate.BindUFunction(Cast<UObject>(this), TEXT("CreateHexGridFlow"));
@@ -39,17 +151,14 @@ void AHexGridCreator::CreateHexGridFlow()
 	case Enum_HexGridCreatorWorkflowState::SpiralCreateCenter:
 		SpiralCreateCenter();
 		break;
-	case Enum_HexGridCreatorWorkflowState::SpiralCreateNeighbors:
-		SpiralCreateNeighbors();
+	case Enum_HexGridCreatorWorkflowState::ParallelCreateCenter:
+		ParallelCreateCenter();
 		break;
 	case Enum_HexGridCreatorWorkflowState::WriteTiles:
 		WriteTilesToFile();
 		break;
-	case Enum_HexGridCreatorWorkflowState::WriteTilesNeighbor:
-		WriteNeighborsToFile();
-		break;
-	case Enum_HexGridCreatorWorkflowState::WriteTileIndices:
-		WriteTileIndicesToFile();
+	case Enum_HexGridCreatorWorkflowState::WriteBinary:
+		WriteBinaryToFile();
 		break;
 	case Enum_HexGridCreatorWorkflowState::WriteParams:
 		WriteParamsToFile();
@@ -70,10 +179,10 @@ void AHexGridCreator::InitWorkflow()
 	InitDirection();
 	InitTileParams();
 	InitLoopData();
-	InitAxialDirections();
 
 	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridCreatorWorkflowState::SpiralCreateCenter;
+	WorkflowState = bParallelCreate ? Enum_HexGridCreatorWorkflowState::ParallelCreateCenter
+		: Enum_HexGridCreatorWorkflowState::SpiralCreateCenter;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 	UE_LOG(HexGridCreator, Log, TEXT("Init workflow done."));
 }
@@ -87,24 +196,12 @@ void AHexGridCreator::InitDirection()
 	RDirection.Set(Vec.X, Vec.Y, Vec.Z);
 	Vec = RDirection.RotateAngleAxis(120.0, ZAxis);
 	SDirection.Set(Vec.X, Vec.Y, Vec.Z);
-
-	//Init Neighbor Directions
-	Vec.Set(1.0, 0.0, 0.0);
-	Vec = Vec.RotateAngleAxis(30.0, ZAxis);
-	float Angle;
-	FVector NDir;
-	for (int32 i = 0; i <= 5; i++)
-	{
-		Angle = i * (-60.0);
-		NDir = Vec.RotateAngleAxis(Angle, ZAxis);
-		NeighborDirVectors.Add(FVector2D(NDir.X, NDir.Y));
-	}
 }
 
 void AHexGridCreator::InitTileParams()
 {
-	TileWidth = TileSize * 2.0;
-	TileHeight = TileSize * FMath::Sqrt(3.0);
+	//Positions are computed per tile from axial coord in fixed point, never accumulated along a ring
+	FixedTileSize = Hex::ToFixed(TileSize);
 
 }
 
@@ -112,42 +209,9 @@ void AHexGridCreator::InitLoopData()
 {
 	FlowControlUtility::InitLoopData(SpiralCreateCenterLoopData);
 	SpiralCreateCenterLoopData.IndexSaved[0] = 1;
-	FlowControlUtility::InitLoopData(SpiralCreateNeighborsLoopData);
-	SpiralCreateNeighborsLoopData.IndexSaved[1] = 1;
 	FlowControlUtility::InitLoopData(WriteTilesLoopData);
-	FlowControlUtility::InitLoopData(WriteNeighborsLoopData);
-	WriteNeighborsLoopData.IndexSaved[0] = 1;
-	FlowControlUtility::InitLoopData(WriteTileIndicesLoopData);
-}
-
-void AHexGridCreator::InitAxialDirections()
-{
-	AxialDirectionVectors.Add(FIntPoint(1, 0));
-	AxialDirectionVectors.Add(FIntPoint(1, -1));
-	AxialDirectionVectors.Add(FIntPoint(0, -1));
-	AxialDirectionVectors.Add(FIntPoint(-1, 0));
-	AxialDirectionVectors.Add(FIntPoint(-1, 1));
-	AxialDirectionVectors.Add(FIntPoint(0, 1));
-}
-
-FIntPoint AHexGridCreator::AxialAdd(const FIntPoint& Hex, const FIntPoint& Vec)
-{
-	return Hex + Vec;
-}
-
-FIntPoint AHexGridCreator::AxialDirection(const int32 Direction)
-{
-	return AxialDirectionVectors[Direction];
-}
-
-FIntPoint AHexGridCreator::AxialNeighbor(const FIntPoint& Hex, const int32 Direction)
-{
-	return AxialAdd(Hex, AxialDirection(Direction));
-}
-
-FIntPoint AHexGridCreator::AxialScale(const FIntPoint& Hex, const int32 Factor)
-{
-	return Hex * Factor;
+	WriteTilesLoopData.IndexSaved[0] = TextTileBegin;
+	ResumeLoopData(Enum_HexGridCreatorWorkflowState::WriteTiles, WriteTilesLoopData);
 }
 
 void AHexGridCreator::ResetProgress()
@@ -169,21 +233,6 @@ void AHexGridCreator::GetProgress(float& Out_Progress)
 	}
 }
 
-M_LOAW_HEXGRID_API FString AHexGridCreator::FloatToString(double value, int32 MaximumFractionalDigits)
-{
-	FNumberFormattingOptions NumberFormatOptions;
-	NumberFormatOptions.AlwaysSign = false;
-	NumberFormatOptions.UseGrouping = false;
-	NumberFormatOptions.RoundingMode = ERoundingMode::HalfFromZero;
-	NumberFormatOptions.MinimumIntegralDigits = 1;
-	NumberFormatOptions.MaximumIntegralDigits = 324;
-	NumberFormatOptions.MinimumFractionalDigits = 0;
-	NumberFormatOptions.MaximumFractionalDigits = MaximumFractionalDigits;
-
-	FText::AsNumber(value, &NumberFormatOptions);
-	return FText::AsNumber(value, &NumberFormatOptions).ToString();
-}
-
 void AHexGridCreator::SpiralCreateCenter()
 {
 	bool OnceLoop0 = true;
@@ -194,32 +243,20 @@ void AHexGridCreator::SpiralCreateCenter()
 
 	if (!SpiralCreateCenterLoopData.HasInitialized) {
 		SpiralCreateCenterLoopData.HasInitialized = true;
-		RingInitFlag = false;
 		InitGridCenter();
-		ProgressTarget = 6 * (1 + GridRange) * GridRange / 2;
+		ProgressTarget = FHexSpiral::TileNum(GridRange) - 1;
 	}
 
 	int32 i = SpiralCreateCenterLoopData.IndexSaved[0];
 	i = i < 1 ? 1 : i;
 	int32 j, k;
 
+	//Ring i, side j, step k of the shared hex spiral, same order as ParallelCreateCenter
 	for (; i <= GridRange; i++)
 	{
 		Indices[0] = i;
-		if (!RingInitFlag) {
-			//Init position2D
-			RingInitFlag = true;
-			FVector2D Vec = i * TileHeight * NeighborDirVectors[RING_START_DIRECTION_INDEX];
-			TmpPosition2D.Set(Vec.X, Vec.Y);
-
-			//Init hex Axial
-			FIntPoint Point = AxialAdd(AxialScale(AxialDirection(RING_START_DIRECTION_INDEX), i), FIntPoint(0, 0));
-			TmpHex.X = Point.X;
-			TmpHex.Y = Point.Y;
-		}
-
 		j = OnceLoop0 ? SpiralCreateCenterLoopData.IndexSaved[1] : 0;
-		for (; j <= 5; j++) {
+		for (; j < FHexSpiral::SideNum; j++) {
 			Indices[1] = j;
 			k = OnceLoop1 ? SpiralCreateCenterLoopData.IndexSaved[2] : 0;
 			for (; k <= i - 1; k++)
@@ -230,22 +267,20 @@ void AHexGridCreator::SpiralCreateCenter()
 					return;
 				}
 
-				AddRingTileAndIndex();
-				FindNeighborTileOfRing(j);
+				AddRingTile(FHexSpiral::RingPoint(i, j, k));
 
 				ProgressCurrent = SpiralCreateCenterLoopData.Count;
 				Count++;
 			}
 			OnceLoop1 = false;
 		}
-		RingInitFlag = false;
 		OnceLoop0 = false;
 	}
 
 	ResetProgress();
 
 	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridCreatorWorkflowState::SpiralCreateNeighbors;
+	WorkflowState = Enum_HexGridCreatorWorkflowState::WriteTiles;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, SpiralCreateCenterLoopData.Rate, false);
 	UE_LOG(HexGridCreator, Log, TEXT("Spiral create center done."));
 }
@@ -256,119 +291,37 @@ void AHexGridCreator::InitGridCenter()
 	Data.AxialCoord.X = 0;
 	Data.AxialCoord.Y = 0;
 	Data.Position2D.Set(0.0, 0.0);
-	Tiles.Empty();
+	Tiles.Empty(FHexSpiral::TileNum(GridRange));
 	Tiles.Add(Data);
-
-	TileIndices.Empty();
-	TileIndices.Add(FIntPoint(0, 0), 0);
-
 }
 
-void AHexGridCreator::AddRingTileAndIndex()
+void AHexGridCreator::AddRingTile(const FIntPoint& AxialCoord)
 {
 	FStructHexTileData Data;
-	Data.AxialCoord.X = TmpHex.X;
-	Data.AxialCoord.Y = TmpHex.Y;
-	Data.Position2D.Set(TmpPosition2D.X, TmpPosition2D.Y);
-	int32 Index = Tiles.Add(Data);
-
-	TileIndices.Add(FIntPoint(TmpHex.X, TmpHex.Y), Index);
-}
-
-void AHexGridCreator::FindNeighborTileOfRing(int32 DirIndex)
-{
-	FVector2D Pos = NeighborDirVectors[DirIndex] * TileHeight + TmpPosition2D;
-	TmpPosition2D.Set(Pos.X, Pos.Y);
-
-	FIntPoint Hex = AxialNeighbor(TmpHex, DirIndex);
-	TmpHex.X = Hex.X;
-	TmpHex.Y = Hex.Y;
+	Data.AxialCoord = AxialCoord;
+	Data.Position2D = Hex::AxialToPosition(FixedTileSize, AxialCoord);
+	Tiles.Add(Data);
 }
 
-void AHexGridCreator::SpiralCreateNeighbors()
+void AHexGridCreator::ParallelCreateCenter()
 {
-	bool OnceLoop0 = true;
-	bool OnceLoop1 = true;
-	bool OnceLoop2 = true;
-	int32 Count = 0;
-	TArray<int32> Indices = { 0, 0, 0, 0 };
-	bool SaveLoopFlag = false;
-
-	if (!SpiralCreateNeighborsLoopData.HasInitialized) {
-		SpiralCreateNeighborsLoopData.HasInitialized = true;
-		RingInitFlag = false;
-		ProgressTarget = Tiles.Num() * 6 * (1 + NeighborRange) * NeighborRange / 2;
-	}
+	int32 TileNum = FHexSpiral::TileNum(GridRange);
+	Tiles.Empty(TileNum);
+	Tiles.SetNum(TileNum);
 
-	int32 TileIndex = SpiralCreateNeighborsLoopData.IndexSaved[0];
-	int32 i, j, k;
-
-	FIntPoint center;
-
-	for (; TileIndex < Tiles.Num(); TileIndex++)
-	{
-		Indices[0] = TileIndex;
-		center = Tiles[TileIndex].AxialCoord;
-		i = OnceLoop0 ? SpiralCreateNeighborsLoopData.IndexSaved[1] : 1;
-		i = i < 1 ? 1 : i;
-		for (; i <= NeighborRange; i++)
-		{
-			Indices[1] = i;
-			if (!RingInitFlag) {
-				RingInitFlag = true;
-
-				AddTileNeighbor(TileIndex, i);
-
-				FIntPoint Point = AxialAdd(AxialScale(AxialDirection(RING_START_DIRECTION_INDEX), i), center);
-				TmpHex.X = Point.X;
-				TmpHex.Y = Point.Y;
-			}
-
-			j = OnceLoop1 ? SpiralCreateNeighborsLoopData.IndexSaved[2] : 0;
-			for (; j <= 5; j++) {
-				Indices[2] = j;
-				k = OnceLoop2 ? SpiralCreateNeighborsLoopData.IndexSaved[3] : 0;
-				for (; k <= i - 1; k++) {
-					Indices[3] = k;
-					FlowControlUtility::SaveLoopData(this, SpiralCreateNeighborsLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
-					if (SaveLoopFlag) {
-						return;
-					}
-
-					SetTileNeighbor(TileIndex, i, j);
-					ProgressCurrent = SpiralCreateNeighborsLoopData.Count;
-					Count++;
-				}
-				OnceLoop2 = false;
-			}
-			RingInitFlag = false;
-			OnceLoop1 = false;
-		}
-		OnceLoop0 = false;
-	}
-
-	ResetProgress();
+	ParallelFor(TileNum, [this](int32 Index) { CreateSpiralTile(Index); });
 
 	FTimerHandle TimerHandle;
 	WorkflowState = Enum_HexGridCreatorWorkflowState::WriteTiles;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, SpiralCreateNeighborsLoopData.Rate, false);
-	UE_LOG(HexGridCreator, Log, TEXT("Spiral create neighbors done."));
-}
-
-void AHexGridCreator::AddTileNeighbor(int32 TileIndex, int32 Radius)
-{
-	FStructHexTileNeighbors neighbors;
-	neighbors.Radius = Radius;
-	Tiles[TileIndex].Neighbors.Add(neighbors);
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGridCreator, Log, TEXT("Parallel create center done."));
 }
 
-void AHexGridCreator::SetTileNeighbor(int32 TileIndex, int32 Radius, int32 DirIndex)
+void AHexGridCreator::CreateSpiralTile(int32 Index)
 {
-	Tiles[TileIndex].Neighbors[Radius - 1].Tiles.Add(FIntPoint(TmpHex.X, TmpHex.Y));
-
-	FIntPoint Hex = AxialNeighbor(TmpHex, DirIndex);
-	TmpHex.X = Hex.X;
-	TmpHex.Y = Hex.Y;
+	FStructHexTileData& Data = Tiles[Index];
+	Data.AxialCoord = FHexSpiral::IndexToPoint(Index);
+	Data.Position2D = Hex::AxialToPosition(FixedTileSize, Data.AxialCoord);
 }
 
 void AHexGridCreator::WriteTilesToFile()
@@ -379,27 +332,30 @@ void AHexGridCreator::WriteTilesToFile()
 	CreateFilePath(TilesDataPath, FullPath);
 
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
+	if (TextTileBegin >= Tiles.Num()) {
+		WorkflowState = Enum_HexGridCreatorWorkflowState::WriteBinary;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteTilesLoopData.Rate, false);
+		UE_LOG(HexGridCreator, Log, TEXT("Tiles data is up to date, only write binary and params."));
+		return;
+	}
+
 	if (!WriteTilesLoopData.HasInitialized) {
 		WriteTilesLoopData.HasInitialized = true;
-		ofs.open(*FullPath, std::ios::out | std::ios::trunc);
-		ProgressTarget = Tiles.Num();
-	}
-	else {
-		ofs.open(*FullPath, std::ios::out | std::ios::app);
+		OpenStageWriter(Enum_HexGridCreatorWorkflowState::WriteTiles, WriteTilesLoopData, TilesDataPath, FullPath);
+		ProgressTarget = Tiles.Num() - TextTileBegin;
 	}
 
-	if (!ofs || !ofs.is_open()) {
+	if (!DataWriter.IsOpen()) {
 		UE_LOG(HexGridCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
 		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
 		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteTilesLoopData.Rate, false);
 		return;
 	}
 
-	WriteTiles(ofs);
+	WriteTiles(DataWriter);
 }
 
-void AHexGridCreator::WriteTiles(std::ofstream& ofs)
+void AHexGridCreator::WriteTiles(FBufferedDataWriter& Writer)
 {
 	int32 Count = 0;
 	TArray<int32> Indices = { 0 };
@@ -411,279 +367,229 @@ void AHexGridCreator::WriteTiles(std::ofstream& ofs)
 		Indices[0] = i;
 		FlowControlUtility::SaveLoopData(this, WriteTilesLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
 		if (SaveLoopFlag) {
-			ofs.close();
+			SaveWriteCheckpoint(Enum_HexGridCreatorWorkflowState::WriteTiles, WriteTilesLoopData, DataFileRelPath + TilesDataFileName);
 			return;
 		}
-		WriteTileLine(ofs, i);
+		WriteTileLine(Writer, i);
 		ProgressCurrent = WriteTilesLoopData.Count;
 		Count++;
 	}
-	ofs.close();
+
 	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridCreatorWorkflowState::WriteTilesNeighbor;
+	if (!Writer.Close()) {
+		UE_LOG(HexGridCreator, Warning, TEXT("Write tiles failed!"));
+		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteTilesLoopData.Rate, false);
+		return;
+	}
+
+	WorkflowState = Enum_HexGridCreatorWorkflowState::WriteBinary;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteTilesLoopData.Rate, false);
 	UE_LOG(HexGridCreator, Log, TEXT("Write tiles done."));
 
 }
 
-void AHexGridCreator::WriteTileLine(std::ofstream& ofs, int32 Index)
+void AHexGridCreator::WriteTileLine(FBufferedDataWriter& Writer, int32 Index)
 {
-	FStructHexTileData Data = Tiles[Index];
-	WriteAxialCoord(ofs, Data);
-	WritePipeDelimiter(ofs);
-	WritePosition2D(ofs, Data);
-	WriteLineEnd(ofs);
+	const FStructHexTileData& Data = Tiles[Index];
+	WriteAxialCoord(Writer, Data);
+	WritePipeDelimiter(Writer);
+	WritePosition2D(Writer, Data);
+	WriteLineEnd(Writer);
 }
 
-void AHexGridCreator::WriteIndices(std::ofstream& ofs, int32 Index)
+void AHexGridCreator::WriteAxialCoord(FBufferedDataWriter& Writer, const FStructHexTileData& Data)
 {
-	FString Str = FString::FromInt(Index);
-	ofs << TCHAR_TO_ANSI(*Str);
+	Writer.WriteInt(Data.AxialCoord.X);
+	WriteCommaDelimiter(Writer);
+	Writer.WriteInt(Data.AxialCoord.Y);
 }
 
-void AHexGridCreator::WriteAxialCoord(std::ofstream& ofs, const FStructHexTileData& Data)
+void AHexGridCreator::WritePosition2D(FBufferedDataWriter& Writer, const FStructHexTileData& Data)
 {
-	FIntPoint AC = Data.AxialCoord;
-	FString Str = FString::FromInt(AC.X);
-	Str.Append(*CommaDelim);
-	Str.Append(FString::FromInt(AC.Y));
-	ofs << TCHAR_TO_ANSI(*Str);
+	Writer.WriteFloat(Data.Position2D.X, 2);
+	WriteCommaDelimiter(Writer);
+	Writer.WriteFloat(Data.Position2D.Y, 2);
 }
 
-void AHexGridCreator::WritePosition2D(std::ofstream& ofs, const FStructHexTileData& Data)
+void AHexGridCreator::WriteParamsToFile()
 {
-	FVector2D Pos2D = Data.Position2D;
-	/*FText Txt = UKismetTextLibrary::Conv_FloatToText(Pos2D.X, ERoundingMode::HalfFromZero, false, false, 1, 324, 0, 2);
-	FString Str = UKismetTextLibrary::Conv_TextToString(Txt);*/
-	FString Str = FloatToString(Pos2D.X, 2);
-	Str.Append(*CommaDelim);
-	/*Txt = UKismetTextLibrary::Conv_FloatToText(Pos2D.Y, ERoundingMode::HalfFromZero, false, false, 1, 324, 0, 2);
-	Str.Append(UKismetTextLibrary::Conv_TextToString(Txt));*/
-	Str.Append(FloatToString(Pos2D.Y, 2));
-	ofs << TCHAR_TO_ANSI(*Str);
-}
+	FString FullPath;
+	FString ParamsDataPath = FString(TEXT(""));
+	ParamsDataPath.Append(DataFileRelPath).Append(ParamsDataFileName);
+	CreateFilePath(ParamsDataPath, FullPath);
 
-void AHexGridCreator::WriteNeighborsToFile()
-{
-	int32 i = WriteNeighborsLoopData.IndexSaved[0];
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
-	ProgressTarget = Tiles.Num() * CalNeighborsWeight(NeighborRange);
-
-	for (; i <= NeighborRange; i++)
-	{
-		FString NeighborPath;
-		FString FullPath;
-		CreateNeighborPath(NeighborPath, i);
-		CreateFilePath(NeighborPath, FullPath);
-
-		if (!WriteNeighborsLoopData.HasInitialized) {
-			WriteNeighborsLoopData.HasInitialized = true;
-			ofs.open(*FullPath, std::ios::out | std::ios::trunc);
-		}
-		else {
-			ofs.open(*FullPath, std::ios::out | std::ios::app);
-		}
-
-		if (!ofs || !ofs.is_open()) {
-			UE_LOG(HexGridCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
-			WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
-			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteNeighborsLoopData.Rate, false);
-			return;
-		}
-		if (!WriteNeighbors(ofs, i)) {
-			return;
-		}
+	ProgressTarget = 1;
+	if (!OpenDataWriter(FullPath, false)) {
+		UE_LOG(HexGridCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
+		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
 	}
 
-	WorkflowState = Enum_HexGridCreatorWorkflowState::WriteTileIndices;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteNeighborsLoopData.Rate, false);
-	UE_LOG(HexGridCreator, Log, TEXT("Write neighbors done."));
+	WriteParams(DataWriter);
 }
 
-void AHexGridCreator::CreateNeighborPath(FString& NeighborPath, int32 Radius)
+void AHexGridCreator::WriteParams(FBufferedDataWriter& Writer)
 {
-	FString TilesNeighborPathPrefix = FString(TEXT(""));
-	TilesNeighborPathPrefix.Append(DataFileRelPath).Append(TEXT("N"));
-	NeighborPath.Append(TilesNeighborPathPrefix).Append(FString::FromInt(Radius)).Append(FString(TEXT(".data")));
-}
+	WriteParamsContent(Writer);
+	ProgressCurrent = 1;
 
-int32 AHexGridCreator::CalNeighborsWeight(int32 Range)
-{
-	int32 weight = 0;
-	for (int32 i = 1; i <= Range; i++)
-	{
-		weight += i * 6;
+	FTimerHandle TimerHandle;
+	if (!Writer.Close()) {
+		UE_LOG(HexGridCreator, Warning, TEXT("Write params failed!"));
+		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
 	}
-	return weight;
-}
-
-bool AHexGridCreator::WriteNeighbors(std::ofstream& ofs, int32 Radius)
-{
-	int32 Count = 0;
-	TArray<int32> Indices = { Radius, 0 };
-	bool SaveLoopFlag = false;
 
-	int32 ProgressPre = Tiles.Num() * CalNeighborsWeight(Radius - 1);
-	int32 ProgressRatio = Radius * 6;
-	int32 i = WriteNeighborsLoopData.IndexSaved[1];
-	for (; i <= Tiles.Num() - 1; i++)
-	{
-		Indices[1] = i;
-		FlowControlUtility::SaveLoopData(this, WriteNeighborsLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
-		if (SaveLoopFlag) {
-			ofs.close();
-			return false;
-		}
-		WriteNeighborLine(ofs, i, Radius);
-		ProgressCurrent = ProgressPre + WriteNeighborsLoopData.Count * ProgressRatio;
-		Count++;
-	}
+	//Params are written last, all data files are complete now
+	DeleteCheckpoint(DataFileRelPath + CheckpointFileName);
 
-	ofs.close();
-	FlowControlUtility::InitLoopData(WriteNeighborsLoopData);
-	WriteNeighborsLoopData.IndexSaved[0] = Radius;
-	UE_LOG(HexGridCreator, Log, TEXT("Write neighbor N%d done."), Radius);
-	return true;
+	WorkflowState = Enum_HexGridCreatorWorkflowState::Done;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGridCreator, Log, TEXT("Write params done."));
 }
 
-void AHexGridCreator::WriteNeighborLine(std::ofstream& ofs, int32 Index, int32 Radius)
+void AHexGridCreator::WriteParamsContent(FBufferedDataWriter& Writer)
 {
-	FStructHexTileNeighbors Neighbors = Tiles[Index].Neighbors[Radius - 1];
-	for (int32 i = 0; i < Neighbors.Tiles.Num(); i++)
-	{
-		FString Str = FString::FromInt(Neighbors.Tiles[i].X);
-		Str.Append(*CommaDelim);
-		Str.Append(FString::FromInt(Neighbors.Tiles[i].Y));
-		if (i != Neighbors.Tiles.Num() - 1) {
-			Str.Append(*SpaceDelim);
-		}
-		ofs << TCHAR_TO_ANSI(*Str);
-	}
-	WriteLineEnd(ofs);
+	Writer.WriteFloat(TileSize, 2);
+	WritePipeDelimiter(Writer);
+	Writer.WriteInt(GridRange);
+	WritePipeDelimiter(Writer);
+	Writer.WriteInt(NeighborRange);
+	WriteLineEnd(Writer);
+	WriteParamsHash(Writer, CalHexGridParamsHash(TileSize, GridRange, NeighborRange));
 }
 
-void AHexGridCreator::WriteTileIndicesToFile()
+void AHexGridCreator::WriteBinaryToFile()
 {
-	FString FullPath;
-	FString TileIndicesDataPath = FString(TEXT(""));
-	TileIndicesDataPath.Append(DataFileRelPath).Append(TileIndicesDataFileName);
-	CreateFilePath(TileIndicesDataPath, FullPath);
-
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
-	if (!WriteTileIndicesLoopData.HasInitialized) {
-		WriteTileIndicesLoopData.HasInitialized = true;
-		ofs.open(*FullPath, std::ios::out | std::ios::trunc);
-		ProgressTarget = Tiles.Num();
-	}
-	else {
-		ofs.open(*FullPath, std::ios::out | std::ios::app);
+	if (!bWriteBinaryData) {
+		WorkflowState = Enum_HexGridCreatorWorkflowState::WriteParams;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
 	}
 
-	if (!ofs || !ofs.is_open()) {
+	FString FullPath;
+	FString BinaryDataPath = FString(TEXT(""));
+	BinaryDataPath.Append(DataFileRelPath).Append(BinaryDataFileName);
+	CreateFilePath(BinaryDataPath, FullPath);
+
+	ProgressTarget = 1;
+	if (!OpenDataWriter(FullPath)) {
 		UE_LOG(HexGridCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
 		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteTileIndicesLoopData.Rate, false);
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 		return;
 	}
 
-	WriteTileIndices(ofs);
+	WriteBinary(DataWriter);
 }
 
-void AHexGridCreator::WriteTileIndices(std::ofstream& ofs)
+void AHexGridCreator::WriteBinary(FBufferedDataWriter& Writer)
 {
-	int32 Count = 0;
-	TArray<int32> Indices = { 0 };
-	bool SaveLoopFlag = false;
+	InitBinarySections();
+	WriteBinaryHeader(Writer);
+	WriteBinarySections(Writer);
+	WriteBinaryTiles(Writer);
+	BinarySections.Empty();
+	BinaryTileOrder.Empty();
+	ProgressCurrent = 1;
 
-	int32 i = WriteTileIndicesLoopData.IndexSaved[0];
-	for (; i <= Tiles.Num() - 1; i++)
-	{
-		Indices[0] = i;
-		FlowControlUtility::SaveLoopData(this, WriteTileIndicesLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
-		if (SaveLoopFlag) {
-			ofs.close();
-			return;
-		}
-		WriteTileIndicesLine(ofs, i);
-		ProgressCurrent = WriteTileIndicesLoopData.Count;
-		Count++;
-	}
-	ofs.close();
 	FTimerHandle TimerHandle;
+	if (!Writer.Close()) {
+		UE_LOG(HexGridCreator, Warning, TEXT("Write binary data failed!"));
+		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
+	}
+
 	WorkflowState = Enum_HexGridCreatorWorkflowState::WriteParams;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteTileIndicesLoopData.Rate, false);
-	UE_LOG(HexGridCreator, Log, TEXT("Write tiles indices done."));
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+	UE_LOG(HexGridCreator, Log, TEXT("Write binary data done."));
 }
 
-void AHexGridCreator::WriteTileIndicesLine(std::ofstream& ofs, int32 Index)
+void AHexGridCreator::InitBinarySections()
 {
-	FIntPoint key = Tiles[Index].AxialCoord;
-	WriteIndicesKey(ofs, key);
-	WritePipeDelimiter(ofs);
-	WriteIndicesValue(ofs, Index);
-	WriteLineEnd(ofs);
-}
+	BinarySections.Empty();
+	BinaryTileOrder.Empty(Tiles.Num());
 
-void AHexGridCreator::WriteIndicesKey(std::ofstream& ofs, const FIntPoint& key)
-{
-	FString Str = FString::FromInt(key.X);
-	Str.Append(*CommaDelim);
-	Str.Append(FString::FromInt(key.Y));
-	ofs << TCHAR_TO_ANSI(*Str);
-}
+	//Center tile
+	AddBinarySection(0, 1, 0);
 
-void AHexGridCreator::WriteIndicesValue(std::ofstream& ofs, int32 Index)
-{
-	FString Str = FString::FromInt(Index);
-	ofs << TCHAR_TO_ANSI(*Str);
+	//Each band of rings is split into 6 sides, side j of ring i holds spiral indices
+	//[1 + 3i(i-1) + j*i, 1 + 3i(i-1) + (j+1)*i)
+	int32 Band = FMath::Max(SectionRingNum, 1);
+	for (int32 RingBegin = 1; RingBegin <= GridRange; RingBegin += Band)
+	{
+		int32 RingEnd = FMath::Min(RingBegin + Band, GridRange + 1);
+		for (int32 j = 0; j < FHexSpiral::SideNum; j++)
+		{
+			AddBinarySection(RingBegin, RingEnd, j);
+		}
+	}
 }
 
-void AHexGridCreator::WriteParamsToFile()
+void AHexGridCreator::AddBinarySection(int32 RingBegin, int32 RingEnd, int32 Side)
 {
-	FString FullPath;
-	FString ParamsDataPath = FString(TEXT(""));
-	ParamsDataPath.Append(DataFileRelPath).Append(ParamsDataFileName);
-	CreateFilePath(ParamsDataPath, FullPath);
-
-	FTimerHandle TimerHandle;
-	std::ofstream ofs;
-	ofs.open(*FullPath, std::ios::out | std::ios::trunc);
-	ProgressTarget = 1;
+	FHexGridBinarySection& Section = BinarySections.AddDefaulted_GetRef();
+	Section.RingBegin = RingBegin;
+	Section.RingEnd = RingEnd;
+	Section.Side = Side;
+	Section.TileBegin = BinaryTileOrder.Num();
 
-	if (!ofs || !ofs.is_open()) {
-		UE_LOG(HexGridCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
-		WorkflowState = Enum_HexGridCreatorWorkflowState::Error;
-		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
-		return;
+	FBox2D Bounds(ForceInit);
+	for (int32 i = RingBegin; i < RingEnd; i++)
+	{
+		int32 First = FHexSpiral::RingBegin(i) + Side * i;
+		int32 Num = (i == 0) ? 1 : i;
+		for (int32 k = 0; k < Num; k++)
+		{
+			BinaryTileOrder.Add(First + k);
+			Bounds += Tiles[First + k].Position2D;
+		}
 	}
 
-	WriteParams(ofs);
+	Section.TileNum = BinaryTileOrder.Num() - Section.TileBegin;
+	Section.MinX = Bounds.Min.X;
+	Section.MinY = Bounds.Min.Y;
+	Section.MaxX = Bounds.Max.X;
+	Section.MaxY = Bounds.Max.Y;
 }
 
-void AHexGridCreator::WriteParams(std::ofstream& ofs)
+void AHexGridCreator::WriteBinaryHeader(FBufferedDataWriter& Writer)
 {
-	WriteParamsContent(ofs);
-	ProgressCurrent = 1;
-	ofs.close();
-	FTimerHandle TimerHandle;
-	WorkflowState = Enum_HexGridCreatorWorkflowState::Done;
-	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
-	UE_LOG(HexGridCreator, Log, TEXT("Write params done."));
+	FHexGridBinaryHeader Header;
+	Header.ParamsHash = CalHexGridParamsHash(TileSize, GridRange, NeighborRange);
+	Header.TileSize = TileSize;
+	Header.GridRange = GridRange;
+	Header.NeighborRange = NeighborRange;
+	Header.TileNum = Tiles.Num();
+	Header.SectionNum = BinarySections.Num();
+	Header.SectionRingNum = FMath::Max(SectionRingNum, 1);
+	Header.SectionsOffset = sizeof(FHexGridBinaryHeader);
+	Header.TilesOffset = Header.SectionsOffset + int64(BinarySections.Num()) * sizeof(FHexGridBinarySection);
+	Writer.WriteRaw(&Header, sizeof(FHexGridBinaryHeader));
 }
 
-void AHexGridCreator::WriteParamsContent(std::ofstream& ofs)
+void AHexGridCreator::WriteBinarySections(FBufferedDataWriter& Writer)
 {
-	/*FText Txt = UKismetTextLibrary::Conv_FloatToText(TileSize, ERoundingMode::HalfFromZero, false, false, 1, 324, 0, 2);
-	FString Str = UKismetTextLibrary::Conv_TextToString(Txt);*/
-	FString Str = FloatToString(TileSize, 2);
-	ofs << TCHAR_TO_ANSI(*Str);
-	WritePipeDelimiter(ofs);
-	Str = FString::FromInt(GridRange);
-	ofs << TCHAR_TO_ANSI(*Str);
-	WritePipeDelimiter(ofs);
-	Str = FString::FromInt(NeighborRange);
-	ofs << TCHAR_TO_ANSI(*Str);
-	WriteLineEnd(ofs);
+	Writer.WriteRaw(BinarySections.GetData(), BinarySections.Num() * sizeof(FHexGridBinarySection));
+}
+
+void AHexGridCreator::WriteBinaryTiles(FBufferedDataWriter& Writer)
+{
+	TArray<FHexGridBinaryTile> Records;
+	Records.SetNumUninitialized(BinaryTileOrder.Num());
+	for (int32 i = 0; i < BinaryTileOrder.Num(); i++)
+	{
+		const FStructHexTileData& Data = Tiles[BinaryTileOrder[i]];
+		Records[i].Q = Data.AxialCoord.X;
+		Records[i].R = Data.AxialCoord.Y;
+		Records[i].X = Data.Position2D.X;
+		Records[i].Y = Data.Position2D.Y;
+	}
+	Writer.WriteRaw(Records.GetData(), Records.Num() * sizeof(FHexGridBinaryTile));
 }
@@ -0,0 +1,466 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HexGridDataLoader.h"
+#include "ChunkedDataReader.h"
+
+#include <charconv>
+#include <algorithm>
+#include <Algo/Sort.h>
+#include <HAL/PlatformFileManager.h>
+#include <Async/MappedFileHandle.h>
+
+DEFINE_LOG_CATEGORY(HexGridDataLoader);
+
+FHexGridDataLoader::FHexGridDataLoader()
+{
+}
+
+FHexGridDataLoader::~FHexGridDataLoader()
+{
+}
+
+bool FHexGridDataLoader::Load()
+{
+	bParamsLoaded = LoadParamsFromFile();
+	bSucceeded = LoadBinaryFromFile() || LoadTextFromFile();
+	return bSucceeded;
+}
+
+bool FHexGridDataLoader::LoadBinaryFromFile()
+{
+	if (!bUseBinaryData || !FPaths::FileExists(BinaryDataPath)) {
+		UE_LOG(HexGridDataLoader, Log, TEXT("Binary data file %s not used, load text data files."), *BinaryDataPath);
+		return false;
+	}
+
+	//Compressed binary is decompressed into memory, raw binary is mapped
+	TArray<uint8> Decompressed;
+	if (FChunkedDataReader::ReadFile(BinaryDataPath, Decompressed)) {
+		if (!LoadBinary(Decompressed.GetData(), Decompressed.Num())) {
+			UE_LOG(HexGridDataLoader, Warning, TEXT("Binary data file %s invalid, load text data files."), *BinaryDataPath);
+			Tiles.Empty();
+			TileMap.Reset();
+			return false;
+		}
+		UE_LOG(HexGridDataLoader, Log, TEXT("Load compressed binary data done!"));
+		return true;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*BinaryDataPath));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion() : nullptr);
+	if (!MappedRegion) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Map file %s failed, load text data files."), *BinaryDataPath);
+		return false;
+	}
+
+	if (!LoadBinary(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize())) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Binary data file %s invalid, load text data files."), *BinaryDataPath);
+		Tiles.Empty();
+		TileMap.Reset();
+		return false;
+	}
+
+	UE_LOG(HexGridDataLoader, Log, TEXT("Load binary data done!"));
+	return true;
+}
+
+bool FHexGridDataLoader::LoadBinary(const uint8* Data, int64 Size)
+{
+	if (Size < int64(sizeof(FHexGridBinaryHeader))) {
+		return false;
+	}
+
+	FHexGridBinaryHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(FHexGridBinaryHeader));
+	if (!ParseBinaryHeader(Header, Size)) {
+		return false;
+	}
+
+	if (bPartialLoad) {
+		return ParseBinarySections(Data, Header);
+	}
+
+	return ParseBinaryTiles(Data, Header);
+}
+
+bool FHexGridDataLoader::ParseBinaryHeader(const FHexGridBinaryHeader& Header, int64 Size)
+{
+	if (Header.Magic != HEXGRID_BINARY_MAGIC || Header.Version != HEXGRID_BINARY_VERSION) {
+		return false;
+	}
+	if (Header.TileNum != FHexSpiral::TileNum(Header.GridRange) || Header.NeighborRange <= 0 || !(Header.TileSize > 0.0f)) {
+		return false;
+	}
+	if (Header.ParamsHash != CalHexGridParamsHash(Header.TileSize, Header.GridRange, Header.NeighborRange)) {
+		return false;
+	}
+	if (bHasParamsHash && Header.ParamsHash != ParamsHash) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Binary data is stale, params hash %u does not match %u."), Header.ParamsHash, ParamsHash);
+		return false;
+	}
+
+	//Sections must lie after the header, inside the file and on record alignment
+	int64 TileNum = Header.TileNum;
+	if (Header.TilesOffset < int64(sizeof(FHexGridBinaryHeader)) || Header.TilesOffset % 4 != 0
+		|| Header.SectionsOffset < int64(sizeof(FHexGridBinaryHeader)) || Header.SectionsOffset % 4 != 0
+		|| Header.TilesOffset + TileNum * int64(sizeof(FHexGridBinaryTile)) > Size
+		|| Header.SectionNum <= 0
+		|| Header.SectionsOffset + int64(Header.SectionNum) * int64(sizeof(FHexGridBinarySection)) > Size) {
+		return false;
+	}
+
+	TileSize = Header.TileSize;
+	GridRange = Header.GridRange;
+	NeighborRange = Header.NeighborRange;
+	return true;
+}
+
+bool FHexGridDataLoader::ParseBinaryTiles(const uint8* Data, const FHexGridBinaryHeader& Header)
+{
+	//Tiles are stored section by section, the spiral index puts each one back in place
+	const FHexGridBinaryTile* Records = reinterpret_cast<const FHexGridBinaryTile*>(Data + Header.TilesOffset);
+	Tiles.Empty(Header.TileNum);
+	Tiles.SetNum(Header.TileNum);
+	TBitArray<> Filled(false, Header.TileNum);
+	for (int32 i = 0; i < Header.TileNum; i++)
+	{
+		if (FHexSpiral::Distance(Records[i].Q, Records[i].R) > Header.GridRange) {
+			return false;
+		}
+		//Tile count matches GridRange, a repeated slot means another one is missing
+		int32 Index = FHexSpiral::AxialToIndex(Records[i].Q, Records[i].R);
+		if (Filled[Index]) {
+			return false;
+		}
+		Filled[Index] = true;
+		FStructHexTileData& Tile = Tiles[Index];
+		Tile.AxialCoord = FIntPoint(Records[i].Q, Records[i].R);
+		Tile.Position2D = FVector2D(Records[i].X, Records[i].Y);
+	}
+	TileMap.Reset();
+	TileMap.Add(0, Tiles.Num());
+	return true;
+}
+
+bool FHexGridDataLoader::ParseBinarySections(const uint8* Data, const FHexGridBinaryHeader& Header)
+{
+	const FHexGridBinarySection* Sections = reinterpret_cast<const FHexGridBinarySection*>(Data + Header.SectionsOffset);
+	const FHexGridBinaryTile* Records = reinterpret_cast<const FHexGridBinaryTile*>(Data + Header.TilesOffset);
+	FBox2D Bounds = GetPartialBounds();
+
+	int32 SectionLoaded = 0;
+	Tiles.Empty();
+	for (int32 i = 0; i < Header.SectionNum; i++)
+	{
+		const FHexGridBinarySection& Section = Sections[i];
+		if (Section.TileBegin < 0 || Section.TileNum <= 0 || Section.TileBegin + Section.TileNum > Header.TileNum) {
+			continue;
+		}
+		FBox2D SectionBounds(FVector2D(Section.MinX, Section.MinY), FVector2D(Section.MaxX, Section.MaxY));
+		if (!Bounds.Intersect(SectionBounds)) {
+			continue;
+		}
+
+		//Section bounds are coarse, keep only tiles inside request bounds
+		SectionLoaded++;
+		for (int32 j = Section.TileBegin; j < Section.TileBegin + Section.TileNum; j++)
+		{
+			FVector2D Position2D(Records[j].X, Records[j].Y);
+			if (!Bounds.IsInsideOrOn(Position2D)) {
+				continue;
+			}
+			FStructHexTileData& Data = Tiles.AddDefaulted_GetRef();
+			Data.AxialCoord = FIntPoint(Records[j].Q, Records[j].R);
+			Data.Position2D = Position2D;
+		}
+	}
+	if (!BuildTileMap()) {
+		return false;
+	}
+
+	UE_LOG(HexGridDataLoader, Log, TEXT("Partial load %d of %d sections, %d of %d tiles."),
+		SectionLoaded, Header.SectionNum, Tiles.Num(), Header.TileNum);
+	return true;
+}
+
+FBox2D FHexGridDataLoader::GetPartialBounds() const
+{
+	//Expand by one tile so border tiles overlapping the bounds are kept
+	return LoadBounds.ExpandBy(TileSize);
+}
+
+bool FHexGridDataLoader::BuildTileMap()
+{
+	//Sections are not in spiral order, text lines are
+	Algo::SortBy(Tiles, [](const FStructHexTileData& Data) { return FHexSpiral::AxialToIndex(Data.AxialCoord); });
+	TileMap.Reset();
+	int32 LastIndex = -1;
+	for (const FStructHexTileData& Data : Tiles)
+	{
+		//Sorted indices must be strictly increasing and inside GridRange
+		int32 Index = FHexSpiral::AxialToIndex(Data.AxialCoord);
+		if (FHexSpiral::Distance(Data.AxialCoord.X, Data.AxialCoord.Y) > GridRange || Index == LastIndex) {
+			UE_LOG(HexGridDataLoader, Warning, TEXT("Tile (%d, %d) is repeated or outside GridRange %d!"),
+				Data.AxialCoord.X, Data.AxialCoord.Y, GridRange);
+			TileMap.Reset();
+			return false;
+		}
+		TileMap.Add(Index);
+		LastIndex = Index;
+	}
+	return true;
+}
+
+bool FHexGridDataLoader::LoadTextFromFile()
+{
+	//Text data has no section directory, partial load filters tiles while parsing
+	if (!bParamsLoaded || !LoadTilesFromFile()) {
+		TextReadBuffer.Empty();
+		return false;
+	}
+	TextReadBuffer.Empty();
+
+	//Lines are in spiral order, a full grid must hold every tile of GridRange
+	if (!bPartialLoad && Tiles.Num() != FHexSpiral::TileNum(GridRange)) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Tiles data holds %d tiles, GridRange %d needs %d!"),
+			Tiles.Num(), GridRange, FHexSpiral::TileNum(GridRange));
+		return false;
+	}
+	if (!BuildTileMap()) {
+		return false;
+	}
+	UE_LOG(HexGridDataLoader, Log, TEXT("Load text data done!"));
+	return true;
+}
+
+bool FHexGridDataLoader::ReadTextLines(const FString& Path, TFunctionRef<bool(const char* Begin, const char* End)> LineFunc)
+{
+	if (!FPaths::FileExists(Path)) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Data file %s not exist!"), *Path);
+		return false;
+	}
+
+	//Compressed data file is decompressed ahead on worker tasks while lines are parsed
+	FChunkedDataReader ChunkReader;
+	TUniquePtr<IFileHandle> FileHandle;
+	bool bChunked = ChunkReader.Open(Path);
+	if (!bChunked) {
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		FileHandle.Reset(PlatformFile.OpenRead(*Path));
+		if (!FileHandle) {
+			UE_LOG(HexGridDataLoader, Warning, TEXT("Open file %s failed!"), *Path);
+			return false;
+		}
+	}
+
+	int64 Remain = bChunked ? ChunkReader.GetRawSize() : FileHandle->Size();
+	int32 Carry = 0;
+	TextReadBuffer.SetNumUninitialized(FMath::Max(TextReadBlockSize, 1), EAllowShrinking::No);
+	while (Remain > 0 || Carry > 0)
+	{
+		//Grow buffer when a single line is longer than one block
+		if (Carry == TextReadBuffer.Num()) {
+			TextReadBuffer.SetNumUninitialized(TextReadBuffer.Num() * 2, EAllowShrinking::No);
+		}
+
+		int64 ReadSize = FMath::Min<int64>(Remain, TextReadBuffer.Num() - Carry);
+		uint8* ReadDest = reinterpret_cast<uint8*>(TextReadBuffer.GetData() + Carry);
+		bool bRead = bChunked ? ChunkReader.Read(ReadDest, ReadSize) : FileHandle->Read(ReadDest, ReadSize);
+		if (ReadSize > 0 && !bRead) {
+			UE_LOG(HexGridDataLoader, Warning, TEXT("Read file %s failed!"), *Path);
+			return false;
+		}
+		Remain -= ReadSize;
+
+		const char* Begin = TextReadBuffer.GetData();
+		const char* End = Begin + Carry + ReadSize;
+		const char* LineBegin = Begin;
+		for (const char* Cur = Begin; Cur < End; Cur++)
+		{
+			if (*Cur != '\n') {
+				continue;
+			}
+			const char* LineEnd = (Cur > LineBegin && *(Cur - 1) == '\r') ? Cur - 1 : Cur;
+			if (LineEnd > LineBegin && !LineFunc(LineBegin, LineEnd)) {
+				UE_LOG(HexGridDataLoader, Warning, TEXT("Parse file %s error!"), *Path);
+				return false;
+			}
+			LineBegin = Cur + 1;
+		}
+
+		Carry = int32(End - LineBegin);
+		if (Remain == 0) {
+			//Last line without line end
+			const char* LineEnd = (Carry > 0 && *(End - 1) == '\r') ? End - 1 : End;
+			if (LineEnd > LineBegin && !LineFunc(LineBegin, LineEnd)) {
+				UE_LOG(HexGridDataLoader, Warning, TEXT("Parse file %s error!"), *Path);
+				return false;
+			}
+			break;
+		}
+		FMemory::Memmove(TextReadBuffer.GetData(), LineBegin, Carry);
+	}
+	return true;
+}
+
+bool FHexGridDataLoader::LoadParamsFromFile()
+{
+	//First line holds params, second line holds params hash, old data files have no hash
+	int32 LineIndex = 0;
+	bHasParamsHash = false;
+	bool flag = ReadTextLines(ParamsDataPath, [this, &LineIndex](const char* Begin, const char* End)
+		{
+			LineIndex++;
+			if (LineIndex == 1) {
+				return ParseParams(Begin, End);
+			}
+			if (LineIndex == 2) {
+				return ParseParamsHash(Begin, End);
+			}
+			return true;
+		});
+
+	if (!flag || LineIndex == 0) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Load params from %s failed!"), *ParamsDataPath);
+		return false;
+	}
+
+	if (bHasParamsHash && ParamsHash != CalHexGridParamsHash(TileSize, GridRange, NeighborRange)) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Params data %s is stale, hash does not match!"), *ParamsDataPath);
+		bHasParamsHash = false;
+		return false;
+	}
+
+	UE_LOG(HexGridDataLoader, Log, TEXT("Load params done!"));
+	return true;
+}
+
+bool FHexGridDataLoader::ParseParams(const char* Begin, const char* End)
+{
+	if (std::count(Begin, End, PipeDelim) + 1 != ParamNum) {
+		return false;
+	}
+
+	const char* Cur = Begin;
+	double Size = 0.0;
+	if (!ParseFloat(Cur, End, Size) || !SkipDelim(Cur, End, PipeDelim)
+		|| !ParseInt(Cur, End, GridRange) || !SkipDelim(Cur, End, PipeDelim)
+		|| !ParseInt(Cur, End, NeighborRange) || !(Size > 0.0)) {
+		return false;
+	}
+	TileSize = float(Size);
+	return true;
+}
+
+bool FHexGridDataLoader::ParseParamsHash(const char* Begin, const char* End)
+{
+	std::from_chars_result Result = std::from_chars(Begin, End, ParamsHash);
+	bHasParamsHash = Result.ec == std::errc();
+	return bHasParamsHash;
+}
+
+bool FHexGridDataLoader::LoadTilesFromFile()
+{
+	Tiles.Empty(bPartialLoad ? 0 : FHexSpiral::TileNum(GridRange));
+	FBox2D Bounds = GetPartialBounds();
+	bool flag = ReadTextLines(TilesDataPath, [this, &Bounds](const char* Begin, const char* End)
+		{
+			FStructHexTileData& Data = Tiles.AddDefaulted_GetRef();
+			if (!ParseTileLine(Begin, End, Data)) {
+				return false;
+			}
+			if (bPartialLoad && !Bounds.IsInsideOrOn(Data.Position2D)) {
+				Tiles.Pop(EAllowShrinking::No);
+			}
+			return true;
+		});
+
+	if (!flag) {
+		UE_LOG(HexGridDataLoader, Warning, TEXT("Load tiles from %s failed!"), *TilesDataPath);
+		return false;
+	}
+
+	UE_LOG(HexGridDataLoader, Log, TEXT("Load tiles done!"));
+	return true;
+}
+
+bool FHexGridDataLoader::ParseTileLine(const char* Begin, const char* End, FStructHexTileData& Data)
+{
+	const char* Cur = Begin;
+	return ParseIntPoint(Cur, End, Data.AxialCoord) && SkipDelim(Cur, End, PipeDelim)
+		&& ParseVector2D(Cur, End, Data.Position2D);
+}
+
+bool FHexGridDataLoader::ParseIntPoint(const char*& Cur, const char* End, FIntPoint& Point)
+{
+	return ParseInt(Cur, End, Point.X) && SkipDelim(Cur, End, CommaDelim) && ParseInt(Cur, End, Point.Y);
+}
+
+bool FHexGridDataLoader::ParseVector2D(const char*& Cur, const char* End, FVector2D& Vec2D)
+{
+	return ParseFloat(Cur, End, Vec2D.X) && SkipDelim(Cur, End, CommaDelim) && ParseFloat(Cur, End, Vec2D.Y);
+}
+
+bool FHexGridDataLoader::ParseInt(const char*& Cur, const char* End, int32& Value)
+{
+	std::from_chars_result Result = std::from_chars(Cur, End, Value);
+	if (Result.ec != std::errc()) {
+		return false;
+	}
+	Cur = Result.ptr;
+	return true;
+}
+
+bool FHexGridDataLoader::ParseFloat(const char*& Cur, const char* End, double& Value)
+{
+	//Creators write plain decimals without exponent, accumulate digits as integer then scale once
+	const char* Ptr = Cur;
+	bool bNegative = Ptr < End && *Ptr == '-';
+	if (bNegative) {
+		Ptr++;
+	}
+
+	int64 Mantissa = 0;
+	int32 FractionalDigits = 0;
+	int32 Digits = 0;
+	bool bFraction = false;
+	for (; Ptr < End; Ptr++)
+	{
+		if (*Ptr >= '0' && *Ptr <= '9') {
+			if (Digits >= 18) {
+				return false;
+			}
+			Mantissa = Mantissa * 10 + (*Ptr - '0');
+			FractionalDigits += bFraction ? 1 : 0;
+			Digits++;
+		}
+		else if (*Ptr == '.' && !bFraction) {
+			bFraction = true;
+		}
+		else {
+			break;
+		}
+	}
+
+	if (Digits == 0) {
+		return false;
+	}
+
+	static constexpr double Pow10[] = { 1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+		1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+	Value = double(Mantissa) / Pow10[FractionalDigits];
+	Value = bNegative ? -Value : Value;
+	Cur = Ptr;
+	return true;
+}
+
+bool FHexGridDataLoader::SkipDelim(const char*& Cur, const char* End, char Delim)
+{
+	if (Cur >= End || *Cur != Delim) {
+		return false;
+	}
+	Cur++;
+	return true;
+}
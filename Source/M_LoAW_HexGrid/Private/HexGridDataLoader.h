@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "HexGridStructDefine.h"
+#include "HexGridDataFormat.h"
+#include "HexSpiral.h"
+
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(HexGridDataLoader, Log, All);
+
+/**
+ * Load hex grid dataset on a worker thread.
+ * Never touches UObjects, AHexGrid adopts the result on game thread when loading is done.
+ */
+class FHexGridDataLoader
+{
+public:
+	//Full paths, set before loading
+	FString ParamsDataPath;
+	FString TilesDataPath;
+	FString BinaryDataPath;
+	bool bUseBinaryData = true;
+	int32 ParamNum = 3;
+	int32 TextReadBlockSize = 1 << 20;
+	//Only load tiles whose center lies in LoadBounds expanded by one tile
+	bool bPartialLoad = false;
+	FBox2D LoadBounds = FBox2D(ForceInit);
+
+	//Loaded data
+	float TileSize = 0.0f;
+	int32 GridRange = 0;
+	int32 NeighborRange = 0;
+	//Tiles in ascending spiral order
+	TArray<FStructHexTileData> Tiles;
+	FHexSpiralTileMap TileMap;
+
+	//Load result
+	bool bSucceeded = false;
+
+private:
+	//Delimiter
+	static constexpr char PipeDelim = '|';
+	static constexpr char CommaDelim = ',';
+
+	//Block read buffer, reused by all text data files
+	TArray<char> TextReadBuffer;
+
+	//Params hash from Params.data, binary data must match it
+	bool bParamsLoaded = false;
+	bool bHasParamsHash = false;
+	uint32 ParamsHash = 0;
+
+public:
+	FHexGridDataLoader();
+	~FHexGridDataLoader();
+
+	bool Load();
+
+private:
+	//Load binary dataset
+	bool LoadBinaryFromFile();
+	bool LoadBinary(const uint8* Data, int64 Size);
+	bool ParseBinaryHeader(const FHexGridBinaryHeader& Header, int64 Size);
+	bool ParseBinaryTiles(const uint8* Data, const FHexGridBinaryHeader& Header);
+	bool ParseBinarySections(const uint8* Data, const FHexGridBinaryHeader& Header);
+
+	//Partial load
+	FBox2D GetPartialBounds() const;
+	bool BuildTileMap();
+
+	//Load text data files
+	bool LoadTextFromFile();
+	bool ReadTextLines(const FString& Path, TFunctionRef<bool(const char* Begin, const char* End)> LineFunc);
+
+	//Load param
+	bool LoadParamsFromFile();
+	bool ParseParams(const char* Begin, const char* End);
+	bool ParseParamsHash(const char* Begin, const char* End);
+
+	//Load tiles data
+	bool LoadTilesFromFile();
+	bool ParseTileLine(const char* Begin, const char* End, FStructHexTileData& Data);
+
+	//Parse text in place, advance Cur past the parsed token
+	static bool ParseIntPoint(const char*& Cur, const char* End, FIntPoint& Point);
+	static bool ParseVector2D(const char*& Cur, const char* End, FVector2D& Vec2D);
+	static bool ParseInt(const char*& Cur, const char* End, int32& Value);
+	static bool ParseFloat(const char*& Cur, const char* End, double& Value);
+	static bool SkipDelim(const char*& Cur, const char* End, char Delim);
+};
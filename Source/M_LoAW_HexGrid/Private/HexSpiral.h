@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+#include "GridTopology.h"
+
+/**
+ * Closed-form spiral order of AHexGridCreator.
+ * Center is index 0, ring i holds indices [1 + 3i(i-1), 1 + 3i(i+1)), it starts at i * direction 4
+ * and side j walks axial direction j for i tiles.
+ * Ring walk and index to axial come from the shared hex topology, axial to index is hex specific.
+ */
+struct FHexSpiral : public FHexGridSpiral
+{
+	static constexpr int32 TileNum(int32 Range)
+	{
+		return PointNum(Range);
+	}
+
+	static constexpr int32 Distance(int32 Q, int32 R)
+	{
+		int32 S = -Q - R;
+		int32 AbsQ = Q < 0 ? -Q : Q;
+		int32 AbsR = R < 0 ? -R : R;
+		int32 AbsS = S < 0 ? -S : S;
+		return AbsQ > AbsR ? (AbsQ > AbsS ? AbsQ : AbsS) : (AbsR > AbsS ? AbsR : AbsS);
+	}
+
+	static constexpr int32 AxialToIndex(int32 Q, int32 R)
+	{
+		int32 Ring = Distance(Q, R);
+		if (Ring == 0) {
+			return 0;
+		}
+
+		int32 S = -Q - R;
+		int32 Side = 0;
+		int32 Step = 0;
+		if (R == Ring && Q < 0) {
+			Side = 0;
+			Step = Q + Ring;
+		}
+		else if (S == -Ring && R > 0) {
+			Side = 1;
+			Step = Q;
+		}
+		else if (Q == Ring && R > -Ring) {
+			Side = 2;
+			Step = -R;
+		}
+		else if (R == -Ring && Q > 0) {
+			Side = 3;
+			Step = Ring - Q;
+		}
+		else if (S == Ring && R < 0) {
+			Side = 4;
+			Step = -Q;
+		}
+		else {
+			Side = 5;
+			Step = R;
+		}
+		return RingBegin(Ring) + Side * Ring + Step;
+	}
+
+	static constexpr void IndexToAxial(int32 Index, int32& OutQ, int32& OutR)
+	{
+		IndexToPoint(Index, OutQ, OutR);
+	}
+
+	FORCEINLINE static int32 AxialToIndex(const FIntPoint& Axial)
+	{
+		return AxialToIndex(Axial.X, Axial.Y);
+	}
+
+	FORCEINLINE static FIntPoint IndexToAxial(int32 Index)
+	{
+		return IndexToPoint(Index);
+	}
+};
+
+//Consecutive spiral indices stored at consecutive tile indices
+struct FHexSpiralRun
+{
+	int32 SpiralBegin = 0;
+	int32 TileBegin = 0;
+	int32 Num = 0;
+};
+
+/**
+ * Spiral index to loaded tile index.
+ * Tiles are kept in ascending spiral order, a full grid is one run, a partial load a few runs per ring.
+ */
+class FHexSpiralTileMap
+{
+private:
+	TArray<FHexSpiralRun> Runs;
+	int32 TileNum = 0;
+
+public:
+	void Reset()
+	{
+		Runs.Reset();
+		TileNum = 0;
+	}
+
+	//Spiral indices of next tiles, must be larger than the previous ones
+	void Add(int32 SpiralBegin, int32 Num = 1)
+	{
+		if (Num <= 0) {
+			return;
+		}
+		if (Runs.Num() > 0 && Runs.Last().SpiralBegin + Runs.Last().Num == SpiralBegin) {
+			Runs.Last().Num += Num;
+		}
+		else {
+			Runs.Add({ SpiralBegin, TileNum, Num });
+		}
+		TileNum += Num;
+	}
+
+	FORCEINLINE int32 Num() const
+	{
+		return TileNum;
+	}
+
+	FORCEINLINE int32 Find(int32 SpiralIndex) const
+	{
+		int32 RunIndex = Runs.Num() == 1 ? 0
+			: Algo::UpperBoundBy(Runs, SpiralIndex, &FHexSpiralRun::SpiralBegin) - 1;
+		if (RunIndex < 0) {
+			return INDEX_NONE;
+		}
+		const FHexSpiralRun& Run = Runs[RunIndex];
+		uint32 Offset = uint32(SpiralIndex - Run.SpiralBegin);
+		return Offset < uint32(Run.Num) ? Run.TileBegin + int32(Offset) : INDEX_NONE;
+	}
+};
+
+namespace HexSpiralCheck
+{
+	constexpr int32 RoundTrip(int32 Index)
+	{
+		int32 Q = 0, R = 0;
+		FHexSpiral::IndexToAxial(Index, Q, R);
+		return FHexSpiral::AxialToIndex(Q, R);
+	}
+}
+
+static_assert(FHexSpiral::AxialToIndex(-1, 1) == 1, "Ring 1 starts at direction 4.");
+static_assert(FHexSpiral::AxialToIndex(0, 1) == 2, "Ring side 0 walks direction 0.");
+static_assert(FHexSpiral::AxialToIndex(-2, 2) == 7, "Ring 2 starts after ring 1.");
+static_assert(HexSpiralCheck::RoundTrip(6) == 6 && HexSpiralCheck::RoundTrip(18) == 18
+	&& HexSpiralCheck::RoundTrip(37) == 37 && HexSpiralCheck::RoundTrip(1000) == 1000, "Spiral index round trip.");
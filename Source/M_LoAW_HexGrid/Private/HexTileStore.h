@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "HexGridStructDefine.h"
+
+//A hex tile always has 6 vertices
+#define HEX_TILE_VERTEX_NUM 6
+
+//Every corner is shared by up to 3 tiles, a tile owns its corners 0 and 1
+#define HEX_TILE_OWNED_CORNER_NUM 2
+
+/**
+ * Tiles of AHexGrid as structure of arrays, every array holds one element per tile in tile order.
+ * Tile passes only stream the attributes they touch, vertices are inline indices into the unique corner table.
+ */
+struct FHexTileStore
+{
+	//Flat top tile corner k is at k * 60 degrees, it is corner CornerOwnerSlot[k] of the tile at CornerOwnerQ/R[k]
+	static constexpr int32 CornerOwnerQ[HEX_TILE_VERTEX_NUM] = { 0, 0, -1, -1, -1, 0 };
+	static constexpr int32 CornerOwnerR[HEX_TILE_VERTEX_NUM] = { 0, 0, 1, 0, 0, -1 };
+	static constexpr int32 CornerOwnerSlot[HEX_TILE_VERTEX_NUM] = { 0, 1, 0, 1, 0, 1 };
+
+	TArray<FIntPoint> AxialCoord;
+	TArray<FVector2D> Position2D;
+	TArray<TStaticArray<int32, HEX_TILE_VERTEX_NUM>> VerticesCorner;
+	TArray<float> PositionZ;
+	TArray<float> AvgPositionZ;
+	TArray<FVector> Normal;
+	TArray<float> AngleToUp;
+	//Block levels never exceed NeighborRange * (ExTimes + 1) + 1, flags are one bit per tile
+	TArray<uint8> TerrainAreaBlockLevel;
+	TArray<uint8> TerrainFlyingBlockLevel;
+	TArray<uint8> TerrainBuildingBlockLevel;
+	TBitArray<> TerrainIsLand;
+	TBitArray<> TerrainAreaConnection;
+
+	//Unique corners, tile Index owns corners HEX_TILE_OWNED_CORNER_NUM * Index + slot,
+	//corners whose owner tile is not loaded follow after all owned corners
+	TArray<FVector2D> CornerPosition2D;
+	TArray<float> CornerPositionZ;
+
+	FORCEINLINE int32 Num() const
+	{
+		return AxialCoord.Num();
+	}
+
+	FORCEINLINE bool IsEmpty() const
+	{
+		return AxialCoord.IsEmpty();
+	}
+
+	FORCEINLINE bool IsValidIndex(int32 Index) const
+	{
+		return AxialCoord.IsValidIndex(Index);
+	}
+
+	//Take loaded tiles, only axial coordinate and 2D position are read
+	void Init(const TArray<FStructHexTileData>& Tiles)
+	{
+		int32 TileNum = Tiles.Num();
+		AxialCoord.SetNumUninitialized(TileNum);
+		Position2D.SetNumUninitialized(TileNum);
+		for (int32 i = 0; i < TileNum; i++)
+		{
+			AxialCoord[i] = Tiles[i].AxialCoord;
+			Position2D[i] = Tiles[i].Position2D;
+		}
+
+		VerticesCorner.SetNumZeroed(TileNum);
+		PositionZ.SetNumZeroed(TileNum);
+		AvgPositionZ.SetNumZeroed(TileNum);
+		Normal.SetNumZeroed(TileNum);
+		AngleToUp.SetNumZeroed(TileNum);
+		TerrainAreaBlockLevel.SetNumZeroed(TileNum);
+		TerrainFlyingBlockLevel.SetNumZeroed(TileNum);
+		TerrainBuildingBlockLevel.SetNumZeroed(TileNum);
+		TerrainIsLand.Init(false, TileNum);
+		TerrainAreaConnection.Init(true, TileNum);
+
+		CornerPosition2D.SetNumZeroed(TileNum * HEX_TILE_OWNED_CORNER_NUM);
+		CornerPositionZ.SetNumZeroed(TileNum * HEX_TILE_OWNED_CORNER_NUM);
+	}
+
+	FORCEINLINE static int32 OwnedCorner(int32 Index, int32 Slot)
+	{
+		return Index * HEX_TILE_OWNED_CORNER_NUM + Slot;
+	}
+
+	int32 AddUnownedCorner(const FVector2D& Position)
+	{
+		CornerPositionZ.Add(0.f);
+		return CornerPosition2D.Add(Position);
+	}
+
+	FORCEINLINE int32 CountIslands() const
+	{
+		return TerrainIsLand.CountSetBits();
+	}
+
+	//Tiles not on island with building block level at least MinLevel, the mask is packed a word at a time
+	//straight from the levels and island bits are cleared with AND NOT on the same word
+	void FindBuildableTiles(int32 MinLevel, TBitArray<>& OutMask) const
+	{
+		int32 TileNum = Num();
+		OutMask.Init(false, TileNum);
+		uint32* MaskWords = OutMask.GetData();
+		const uint32* IslandWords = TerrainIsLand.GetData();
+		int32 WordNum = FMath::DivideAndRoundUp(TileNum, int32(NumBitsPerDWORD));
+		for (int32 w = 0; w < WordNum; w++)
+		{
+			int32 Begin = w * NumBitsPerDWORD;
+			int32 End = FMath::Min(Begin + int32(NumBitsPerDWORD), TileNum);
+			uint32 Word = 0;
+			for (int32 i = Begin; i < End; i++)
+			{
+				Word |= uint32(TerrainBuildingBlockLevel[i] >= MinLevel) << (i - Begin);
+			}
+			MaskWords[w] = Word & ~IslandWords[w];
+		}
+	}
+
+	//Blueprint view of one tile
+	FStructHexTileData GetTileData(int32 Index) const
+	{
+		FStructHexTileData Data;
+		Data.AxialCoord = AxialCoord[Index];
+		Data.Position2D = Position2D[Index];
+		Data.PositionZ = PositionZ[Index];
+		for (int32 Corner : VerticesCorner[Index])
+		{
+			Data.VerticesPostion2D.Add(CornerPosition2D[Corner]);
+			Data.VerticesPositionZ.Add(CornerPositionZ[Corner]);
+		}
+		Data.AvgPositionZ = AvgPositionZ[Index];
+		Data.Normal = Normal[Index];
+		Data.AngleToUp = AngleToUp[Index];
+		Data.TerrainAreaBlockLevel = TerrainAreaBlockLevel[Index];
+		Data.TerrainFlyingBlockLevel = TerrainFlyingBlockLevel[Index];
+		Data.TerrainIsLand = TerrainIsLand[Index];
+		Data.TerrainBuildingBlockLevel = TerrainBuildingBlockLevel[Index];
+		Data.TerrainAreaConnection = TerrainAreaConnection[Index];
+		return Data;
+	}
+};
@@ -3,13 +3,14 @@
 #pragma once
 
 #include "Hex.h"
+#include "HexSpiral.h"
+#include "HexTileStore.h"
+#include "HexChunk.h"
 #include "TerrainStructDefine.h"
 #include "HexGridStructDefine.h"
 
-//#include <iostream>
-#include <fstream>
-
 #include "CoreMinimal.h"
+#include "Tasks/Task.h"
 #include "GameFramework/Actor.h"
 #include "HexGrid.generated.h"
 
@@ -19,10 +20,10 @@ UENUM(BlueprintType)
 enum class Enum_HexGridWorkflowState : uint8
 {
 	InitWorkflow,
-	LoadParams,
-	LoadTileIndices,
-	LoadTiles,
-	LoadNeighbors,
+	WaitTerrainBounds,
+	LoadData,
+	WaitLoadData,
+	CreateTilesNeighbors,
 	CreateTilesVertices,
 	WaitTerrain,
 	SetTilesPosZ,
@@ -35,6 +36,7 @@ enum class Enum_HexGridWorkflowState : uint8
 	FindTilesIsland,
 	SetTilesBuildingBlockLevel,
 	SetTilesBuildingBlockLevelEx,
+	SaveSnapshot,
 	AddInstances,
 	Done,
 	Error
@@ -48,6 +50,13 @@ enum class Enum_BlockMode : uint8
 	FlyingBlock,
 };
 
+UENUM(BlueprintType)
+enum class Enum_HexGridTileOrder : uint8
+{
+	Spiral,
+	Morton,
+};
+
 UCLASS(MinimalAPI)
 class /*M_LOAW_HEXGRID_API*/ AHexGrid : public AActor
 {
@@ -67,8 +76,9 @@ private:
 	//Timer handle
 	FTimerHandle CheckTimerHandle;
 
-	//ifstream for data load
-	std::ifstream DataLoadStream;
+	//Background data load
+	TSharedPtr<class FHexGridDataLoader> DataLoader;
+	UE::Tasks::FTask DataLoadTask;
 
 	//Terrain
 	class ATerrain* Terrain;
@@ -83,7 +93,16 @@ private:
 	TArray<FStructLoopData> AreaBlockLevelExLoopDatas;
 
 	//Create tiles vertices tmp data
-	TArray<FVector> TileVerticesVectors;
+	//Corners on the grid border whose owner tile is not loaded, keyed by owner axial coordinate and slot
+	TMap<FIntVector, int32> UnownedCorners;
+
+	//Axial offsets of neighbor rings 1..NeighborRange, ring Radius starts at 3 * Radius * (Radius - 1)
+	TArray<FIntPoint> RingOffsets;
+
+	//Loaded neighbor tile indices of all tiles, row Index * NeighborRange + Radius - 1 is ring Radius of tile Index,
+	//row spans [NeighborOffsets[Row], NeighborOffsets[Row + 1]) of NeighborIndices
+	TArray<int32> NeighborIndices;
+	TArray<int32> NeighborOffsets;
 
 	//Hex ISM mesh
 	float HexInstanceScale = 1.0;
@@ -98,6 +117,9 @@ private:
 	TArray<TSet<int32>> MaxAreaBlockTileChunks;
 	TQueue<int32> CheckAreaConnectionFrontier;
 
+	//Key of analysed tile state snapshot
+	uint32 SnapshotKey = 0;
+
 	//controll
 	APlayerController* Controller;
 
@@ -113,25 +135,19 @@ protected:
 	float DefaultTimerRate = 0.01f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Timer")
 	float CheckTimerRate = 0.02f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Timer")
+	float WaitLoadDataRate = 0.05f;
 
 	//Path
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
 	FString ParamsDataPath = FString(TEXT("Data/HexGrid/Params.data"));
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
-	FString TileIndicesDataPath = FString(TEXT("Data/HexGrid/TileIndices.data"));
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
 	FString TilesDataPath = FString(TEXT("Data/HexGrid/Tiles.data"));
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
-	FString NeighborsDataPathPrefix = FString(TEXT("Data/HexGrid/N"));
+	FString BinaryDataPath = FString(TEXT("Data/HexGrid/HexGrid.bin"));
 
 	//Loop BP
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
-	FStructLoopData LoadTileIndicesLoopData;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
-	FStructLoopData LoadTilesLoopData;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
-	FStructLoopData LoadNeighborsLoopData;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	FStructLoopData CreateTilesVerticesLoopData;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	FStructLoopData SetTilesPosZLoopData;
@@ -152,11 +168,21 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	FStructLoopData AddTilesInstanceLoopData;
 
-	//Load from data file
-	UPROPERTY(BlueprintReadOnly)
-	TArray<FStructHexTileData> Tiles;
-	UPROPERTY(BlueprintReadOnly)
-	TMap<FIntPoint, int32> TileIndices;
+	//Load from data file, read through GetTileData
+	FHexTileStore Tiles;
+	//Tiles are in spiral order, tile index is derived from axial coordinate
+	FHexSpiralTileMap TileMap;
+	//Spiral tile position to tile index, empty for spiral order
+	TArray<int32> TileRemap;
+
+	//Super-hex chunks of loaded tiles
+	TArray<FHexGridChunk> Chunks;
+	TMap<FIntPoint, int32> ChunkIndices;
+
+	//Dense tile index over axial bounds of loaded tiles, INDEX_NONE for cells without tile
+	TArray<int32> DenseTileLookup;
+	FIntPoint DenseLookupMin = FIntPoint(0, 0);
+	FIntPoint DenseLookupSize = FIntPoint(0, 0);
 
 	//Workflow
 	UPROPERTY(BlueprintReadOnly)
@@ -168,13 +194,47 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Common")
 	bool bShowGrid = false;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Common")
+	bool bUseBinaryData = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Common")
 	Enum_BlockMode GridShowMode = Enum_BlockMode::AreaBlock;
 
+	//Tile lookup through a dense array over the axial bounding rhombus instead of spiral runs,
+	//one int32 per cell, (2 * GridRange + 1)^2 cells for a full grid
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Lookup")
+	bool bDenseTileLookup = true;
+
+	//Memory order of loaded tiles, Morton order of axial coordinate keeps ring neighbors close for BFS passes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Lookup")
+	Enum_HexGridTileOrder TileOrder = Enum_HexGridTileOrder::Spiral;
+
+	//Radius of super-hex chunks grouping nearby tiles, region queries skip chunks by bounds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Chunk", meta = (ClampMin = "1"))
+	int32 ChunkRadius = 8;
+
+	//Partial load, only tiles inside bounds are loaded
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|PartialLoad")
+	bool bPartialLoad = false;
+	//Use terrain bounds from ATerrain width and height instead of PartialLoadBounds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|PartialLoad")
+	bool bPartialLoadTerrainBounds = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|PartialLoad")
+	FBox2D PartialLoadBounds = FBox2D(FVector2D(-100000.0, -100000.0), FVector2D(100000.0, 100000.0));
+
+	//Snapshot of analysed tile state in Saved directory, skips analysis stages when key matches
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Snapshot")
+	bool bUseSnapshot = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Snapshot")
+	FString SnapshotRelPath = FString(TEXT("HexGrid/"));
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Snapshot")
+	FString SnapshotFileName = FString(TEXT("HexGridSnapshot.bin"));
+
 	//Params
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Params")
 	int32 ParamNum = 3;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Custom|Params")
 	float TileSize = 0.0f;
+	//TileSize in fixed units of Hex::PositionScale, tile positions and mouse picking are computed from it
+	int64 FixedTileSize = 0;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Custom|Params")
 	int32 GridRange = 10;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Custom|Params")
@@ -259,39 +319,24 @@ private:
 	void InitAreaBlockLevelExLoopDatas();
 	void InitBulidingBlockLevelExLoopDatas();
 
-	//Read file func
-	bool GetValidFilePath(const FString& RelPath, FString& FullPath);
-
-	//Load param
-	void LoadParamsFromFile();
-	void LoadParams(std::ifstream& ifs);
-	bool ParseParams(const FString& line);
-
-	//Load tiles indices data
-	void LoadTileIndicesFromFile();
-	void LoadTileIndices(std::ifstream& ifs);
-	void ParseTileIndexLine(const FString& line);
-
-	//Load tiles data
-	void LoadTilesFromFile();
-	void LoadTiles(std::ifstream& ifs);
-	void ParseTileLine(const FString& line, FStructHexTileData& Data);
-	void ParseIndex(const FString& ValueStr, const FString& KeyStr);
-	void ParseAxialCoord(const FString& Str, FStructHexTileData& Data);
-	void ParsePosition2D(const FString& Str, FStructHexTileData& Data);
-
-	//Load NeighborData
-	void LoadNeighborsFromFile();
-	void CreateNeighborPath(FString& NeighborPath, int32 Radius);
-	bool LoadNeighbors(std::ifstream& ifs, int32 Radius);
-	void ParseNeighborsLine(const FString& Str, int32 Index, int32 Radius);
-	void ParseNeighbors(const FString& Str, int32 Index, int32 Radius);
-
-	//Parse string to other data type
-	void ParseIntPoint(const FString& Str, FIntPoint& Point);
-	void ParseVector2D(const FString& Str, FVector2D& Vec2D);
-	void ParseVector(const FString& Str, FVector& Vec);
-	void ParseInt(const FString& Str, int32& value);
+	//Terrain bounds for partial load
+	void WaitTerrainBounds();
+	bool FindTerrain();
+
+	//Load data files on a background task
+	void LoadData();
+	void WaitLoadData();
+	void InitTilesPosition2D();
+	void SortTilesByOrder(TArray<FStructHexTileData>& LoadedTiles);
+	void BuildDenseTileLookup();
+	void BuildChunks();
+
+	//Create neighbors from axial coordinate
+	void CreateTilesNeighbors();
+	void InitRingOffsets();
+	void CountTileNeighbors(int32 Index);
+	void FillTileNeighbors(int32 Index);
+	void FindRingNeighbors(TArray<FIntPoint>& RingTiles, const FIntPoint& Center, int32 Radius);
 
 	//Loop Function for all workflow of tiles loop
 	bool TilesLoopFunction(TFunction<void()> InitFunc, TFunction<void(int32 LoopIndex)> LoopFunc,
@@ -305,23 +350,33 @@ private:
 	//Wait terrain noise
 	void WaitTerrain();
 
+	//Analysed tile state snapshot
+	void InitSnapshotKey();
+	FString GetSnapshotPath();
+	bool LoadSnapshot();
+	bool ParseSnapshot(const uint8* Data, int64 Size);
+	void SaveSnapshot();
+	bool SaveSnapshotToFile();
+
 	//Set tiles PosZ
 	void SetTilesPosZ();
+	void InitSetTilesPosZ();
 	void SetTilePosZ(int32 Index);
-	void SetTileCenterPosZ(FStructHexTileData& Data);
-	void SetTileVerticesPosZ(FStructHexTileData& Data);
+	void SetTileCenterPosZ(int32 Index);
+	void SetTileCornersPosZ(int32 Index);
 
 	//Calculate Normal
 	void CalTilesNormal();
 	void InitCalTilesNormal();
 	void CalTileNormal(int32 Index);
+	void SetTileAvgPosZ(int32 Index);
 
 	//Set Area block level
 	void SetTilesAreaBlockLevel();
 	void InitSetTilesAreaBlockLevel();
-	bool SetTileAreaBlock(FStructHexTileData& Data, FStructHexTileData& CheckData, int32 BlockLevel);
+	bool SetTileAreaBlock(int32 Index, int32 CheckIndex, int32 BlockLevel);
 	void SetTileAreaBlockLevelByNeighbors(int32 Index);
-	bool SetTileAreaBlockLevelByNeighbor(FStructHexTileData& Data, int32 Index);
+	bool SetTileAreaBlockLevelByNeighbor(int32 Index, int32 Radius);
 
 	//Set Area block level extension
 	void SetTilesAreaBlockLevelEx();
@@ -345,9 +400,9 @@ private:
 	//Set Building Block level
 	void SetTilesBuildingBlockLevel();
 	void InitSetTilesBuildingBlockLevel();
-	bool SetTileBuildingBlock(FStructHexTileData& Data, FStructHexTileData& CheckData, int32 BuildingBlockLevel);
+	bool SetTileBuildingBlock(int32 Index, int32 CheckIndex, int32 BuildingBlockLevel);
 	void SetTileBuildingBlockLevelByNeighbors(int32 Index);
-	bool SetTileBuildingBlockLevelByNeighbor(FStructHexTileData& Data, int32 Index);
+	bool SetTileBuildingBlockLevelByNeighbor(int32 Index, int32 Radius);
 
 	//Set Building Block level extension
 	void SetTilesBuildingBlockLevelEx();
@@ -357,6 +412,7 @@ private:
 	//Add Grid tiles ISM
 	void AddTilesInstance();
 	void InitAddTilesInstance();
+	void UpdateChunksStats();
 	int32 AddTileInstance(int32 Index);
 	int32 AddISM(int32 Index, UInstancedStaticMeshComponent* ISM, float ZOffset = 0.f);
 
@@ -364,7 +420,29 @@ private:
 	void AddTileInstanceData(int32 TileIndex, int32 InstanceIndex);
 
 	bool IsInMapRange(int32 Index);
-	bool IsInMapRange(const FStructHexTileData& Tile);
+
+	//Index into Tiles, INDEX_NONE when the tile is outside the grid or not loaded
+	FORCEINLINE int32 FindTileIndex(const FIntPoint& Axial) const
+	{
+		if (DenseTileLookup.Num() > 0) {
+			uint32 X = uint32(Axial.X - DenseLookupMin.X);
+			uint32 Y = uint32(Axial.Y - DenseLookupMin.Y);
+			return X < uint32(DenseLookupSize.X) && Y < uint32(DenseLookupSize.Y)
+				? DenseTileLookup[Y * DenseLookupSize.X + X] : INDEX_NONE;
+		}
+		if (FHexSpiral::Distance(Axial.X, Axial.Y) > GridRange) {
+			return INDEX_NONE;
+		}
+		int32 Index = TileMap.Find(FHexSpiral::AxialToIndex(Axial));
+		return Index == INDEX_NONE || TileRemap.IsEmpty() ? Index : TileRemap[Index];
+	}
+
+	//Loaded tile indices on ring Radius (1..NeighborRange) around tile Index
+	FORCEINLINE TConstArrayView<int32> GetTileNeighbors(int32 Index, int32 Radius) const
+	{
+		int32 Row = Index * NeighborRange + Radius - 1;
+		return TConstArrayView<int32>(NeighborIndices.GetData() + NeighborOffsets[Row], NeighborOffsets[Row + 1] - NeighborOffsets[Row]);
+	}
 
 public:	
 	// Called every frame
@@ -380,9 +458,32 @@ public:
 		return WorkflowState == Enum_HexGridWorkflowState::Done;
 	}
 
+	//Tile accessors
+	UFUNCTION(BlueprintCallable)
+	FORCEINLINE int32 GetTileNum() const
+	{
+		return Tiles.Num();
+	}
+
+	UFUNCTION(BlueprintCallable)
+	FStructHexTileData GetTileData(int32 Index) const;
+
+	//Whole map tile filters
+	UFUNCTION(BlueprintCallable)
+	FORCEINLINE int32 GetIslandTileNum() const
+	{
+		return Tiles.CountIslands();
+	}
+
+	UFUNCTION(BlueprintCallable)
+	void FindBuildableTiles(int32 MinBuildingBlockLevel, TArray<int32>& OutTileIndices) const;
+
+	//Indices of tiles with center inside box
+	UFUNCTION(BlueprintCallable)
+	void FindTilesInBox(const FBox2D& Box, TArray<int32>& OutTileIndices) const;
+
 private:
 	//Mouse over
-	Hex PosToHex(const FVector2D& Point, float Size);
 	void FindNeighborTilesByRadius(TArray<FIntPoint>& NeighborTiles, int32 CenterIndex, int32 Radius);
 	void AddMouseOverTilesInstance();
 	void RemoveMouseOverTilesInstance();
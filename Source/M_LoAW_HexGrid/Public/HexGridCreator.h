@@ -4,6 +4,7 @@
 
 #include "TerrainStructDefine.h"
 #include "HexGridStructDefine.h"
+#include "HexGridDataFormat.h"
 #include "CoreMinimal.h"
 #include "DataCreator.h"
 #include "HexGridCreator.generated.h"
@@ -15,17 +16,14 @@ enum class Enum_HexGridCreatorWorkflowState : uint8
 {
 	InitWorkflow,
 	SpiralCreateCenter,
-	SpiralCreateNeighbors,
+	ParallelCreateCenter,
 	WriteTiles,
-	WriteTilesNeighbor,
-	WriteTileIndices,
+	WriteBinary,
 	WriteParams,
 	Done,
 	Error
 };
 
-#define RING_START_DIRECTION_INDEX	4
-
 UCLASS(MinimalAPI)
 class AHexGridCreator : public ADataCreator
 {
@@ -41,25 +39,20 @@ private:
 	FVector RDirection;
 	FVector SDirection;
 
-	TArray<FVector2D> NeighborDirVectors;
-
-	float TileWidth;
-	float TileHeight;
+	//TileSize in fixed units of Hex::PositionScale
+	int64 FixedTileSize = 0;
 
 	//delegate
 	FTimerDynamicDelegate WorkflowDelegate;
 
 	TArray<FStructHexTileData> Tiles;
-	TMap<FIntPoint, int32> TileIndices;
 
-	//Flag for spiral ring
-	bool RingInitFlag = false;
+	//Tiles already in text data files, writing starts from here
+	int32 TextTileBegin = 0;
 
-	TArray<FIntPoint> AxialDirectionVectors;
-
-	//Save temp data for SpiralCreateCenter and SpiralCreateNeighbors
-	FVector2D TmpPosition2D;
-	FIntPoint TmpHex;
+	//Section directory and stored tile order of binary dataset
+	TArray<FHexGridBinarySection> BinarySections;
+	TArray<int32> BinaryTileOrder;
 
 	//Temp data for create vertices
 	TArray<FVector> OuterVectors;
@@ -84,9 +77,22 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
 	FString TilesDataFileName = FString(TEXT("Tiles.data"));
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
-	FString TileIndicesDataFileName = FString(TEXT("TileIndices.data"));
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
 	FString ParamsDataFileName = FString(TEXT("Params.data"));
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
+	FString BinaryDataFileName = FString(TEXT("HexGrid.bin"));
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
+	FString CheckpointFileName = FString(TEXT("Checkpoint.data"));
+
+	//Parallel
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Parallel")
+	bool bParallelCreate = true;
+
+	//Binary
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Binary")
+	bool bWriteBinaryData = true;
+	//Rings per binary section, AHexGrid loads only sections intersecting its bounds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Binary", meta = (ClampMin = "1"))
+	int32 SectionRingNum = 16;
 
 	//Timer
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Timer")
@@ -96,13 +102,7 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	struct FStructLoopData SpiralCreateCenterLoopData;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
-	struct FStructLoopData SpiralCreateNeighborsLoopData;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	struct FStructLoopData WriteTilesLoopData;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
-	struct FStructLoopData WriteNeighborsLoopData;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
-	struct FStructLoopData WriteTileIndicesLoopData;
 
 	//Workflow
 	UPROPERTY(BlueprintReadWrite)
@@ -115,6 +115,16 @@ protected:
 	int32 ProgressCurrent = 0;
 
 private:
+	//Dataset cache
+	bool IsCachedDataValid();
+	void InitIncrementalWrite();
+
+	//Checkpoint of text write stages, tiles are recreated on resume
+	bool InitResume();
+	void ResumeLoopData(Enum_HexGridCreatorWorkflowState Stage, FStructLoopData& LoopData);
+	bool OpenStageWriter(Enum_HexGridCreatorWorkflowState Stage, FStructLoopData& LoopData, const FString& RelPath, const FString& FullPath);
+	void SaveWriteCheckpoint(Enum_HexGridCreatorWorkflowState Stage, const FStructLoopData& LoopData, const FString& RelPath);
+
 	//Timer delegate
 	void BindDelegate();
 
@@ -127,53 +137,38 @@ private:
 	void InitDirection();
 	void InitTileParams();
 	void InitLoopData();
-	void InitAxialDirections();
-
-	//Hex axial coordinate function
-	FIntPoint AxialAdd(const FIntPoint& Hex, const FIntPoint& Vec);
-	FIntPoint AxialDirection(const int32 Direction);
-	FIntPoint AxialNeighbor(const FIntPoint& Hex, const int32 Direction);
-	FIntPoint AxialScale(const FIntPoint& Hex, const int32 Factor);
 
 	void ResetProgress();
 
 	//Create center
 	void SpiralCreateCenter();
 	void InitGridCenter();
-	void AddRingTileAndIndex();
-	void FindNeighborTileOfRing(int32 DirIndex);
+	void AddRingTile(const FIntPoint& AxialCoord);
 
-	//Create neighbors
-	void SpiralCreateNeighbors();
-	void AddTileNeighbor(int32 TileIndex, int32 Radius);
-	void SetTileNeighbor(int32 TileIndex, int32 Radius, int32 DirIndex);
+	//Create center in parallel, every tile computed from its spiral index
+	void ParallelCreateCenter();
+	void CreateSpiralTile(int32 Index);
 
 	//Write hex tiles data to file
 	void WriteTilesToFile();
-	void WriteTiles(std::ofstream& ofs);
-	void WriteTileLine(std::ofstream& ofs, int32 Index);
-	void WriteIndices(std::ofstream& ofs, int32 Index);
-	void WriteAxialCoord(std::ofstream& ofs, const FStructHexTileData& Data);
-	void WritePosition2D(std::ofstream& ofs, const FStructHexTileData& Data);
-
-	//Write neighbors to file
-	void WriteNeighborsToFile();
-	void CreateNeighborPath(FString& NeighborPath, int32 Radius);
-	int32 CalNeighborsWeight(int32 Range);
-	bool WriteNeighbors(std::ofstream& ofs, int32 Radius);
-	void WriteNeighborLine(std::ofstream& ofs, int32 Index, int32 Radius);
-
-	//Write tile indices data to file
-	void WriteTileIndicesToFile();
-	void WriteTileIndices(std::ofstream& ofs);
-	void WriteTileIndicesLine(std::ofstream& ofs, int32 Index);
-	void WriteIndicesKey(std::ofstream& ofs, const FIntPoint& key);
-	void WriteIndicesValue(std::ofstream& ofs, int32 Index);
+	void WriteTiles(FBufferedDataWriter& Writer);
+	void WriteTileLine(FBufferedDataWriter& Writer, int32 Index);
+	void WriteAxialCoord(FBufferedDataWriter& Writer, const FStructHexTileData& Data);
+	void WritePosition2D(FBufferedDataWriter& Writer, const FStructHexTileData& Data);
 
 	//Write info data to file
 	void WriteParamsToFile();
-	void WriteParams(std::ofstream& ofs);
-	void WriteParamsContent(std::ofstream& ofs);
+	void WriteParams(FBufferedDataWriter& Writer);
+	void WriteParamsContent(FBufferedDataWriter& Writer);
+
+	//Write binary dataset to file
+	void WriteBinaryToFile();
+	void WriteBinary(FBufferedDataWriter& Writer);
+	void InitBinarySections();
+	void AddBinarySection(int32 RingBegin, int32 RingEnd, int32 Side);
+	void WriteBinaryHeader(FBufferedDataWriter& Writer);
+	void WriteBinarySections(FBufferedDataWriter& Writer);
+	void WriteBinaryTiles(FBufferedDataWriter& Writer);
 
 public:
 	UFUNCTION(BlueprintCallable)
@@ -185,6 +180,4 @@ public:
 		return WorkflowState < Enum_HexGridCreatorWorkflowState::Done;
 	}
 
-	M_LOAW_HEXGRID_API FString FloatToString(double value, int32 MaximumFractionalDigits);
-
 };
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Crc.h"
+
+//Binary dataset written by AHexGridCreator and memory-mapped by AHexGrid.
+//Layout: Header | Sections[SectionNum] | Tiles[TileNum]
+//Tiles are stored section by section, a section is one side of a band of SectionRingNum rings,
+//section 0 holds the center tile. Tile indices and neighbor rings are not stored,
+//AHexGrid derives both from the axial coordinates.
+#define HEXGRID_BINARY_MAGIC	0x44584548
+#define HEXGRID_BINARY_VERSION	5
+
+//Version of generated data, bump when creator output changes for the same params
+#define HEXGRID_DATA_VERSION	2
+
+//Hash of generating params, stored as second line of Params.data and in binary header.
+//TileSize is hashed at the 2 fractional digits written to Params.data.
+inline uint32 CalHexGridParamsHash(float TileSize, int32 GridRange, int32 NeighborRange)
+{
+	int64 Params[4] = { HEXGRID_DATA_VERSION, FMath::RoundHalfFromZero(double(TileSize) * 100.0), GridRange, NeighborRange };
+	return FCrc::MemCrc32(Params, sizeof(Params));
+}
+
+struct FHexGridBinaryHeader
+{
+	uint32 Magic = HEXGRID_BINARY_MAGIC;
+	uint32 Version = HEXGRID_BINARY_VERSION;
+	uint32 ParamsHash = 0;
+	uint32 Flags = 0;
+	float TileSize = 0.0f;
+	int32 GridRange = 0;
+	int32 NeighborRange = 0;
+	int32 TileNum = 0;
+	int64 TilesOffset = 0;
+	int64 Reserved = 0;
+	int32 SectionNum = 0;
+	int32 SectionRingNum = 0;
+	int64 SectionsOffset = 0;
+};
+
+//Section directory record, tiles [TileBegin, TileBegin + TileNum) in stored order
+struct FHexGridBinarySection
+{
+	int32 RingBegin = 0;
+	int32 RingEnd = 0;
+	int32 Side = 0;
+	int32 TileBegin = 0;
+	int32 TileNum = 0;
+	int32 Reserved = 0;
+	//Bounds of tile centers
+	float MinX = 0.0f;
+	float MinY = 0.0f;
+	float MaxX = 0.0f;
+	float MaxY = 0.0f;
+};
+
+//Fixed-size tile record
+struct FHexGridBinaryTile
+{
+	int32 Q = 0;
+	int32 R = 0;
+	float X = 0.0f;
+	float Y = 0.0f;
+};
+
+static_assert(sizeof(FHexGridBinaryHeader) == 64, "FHexGridBinaryHeader layout changed.");
+static_assert(sizeof(FHexGridBinarySection) == 40, "FHexGridBinarySection layout changed.");
+static_assert(sizeof(FHexGridBinaryTile) == 16, "FHexGridBinaryTile layout changed.");
+
+//Snapshot of analysed tile state written and memory-mapped by AHexGrid.
+//Layout: Header | Tiles[TileNum] | CornersPositionZ[CornerNum], tiles in AHexGrid stored tile order,
+//corner altitudes in AHexGrid corner table order.
+//Key covers dataset, terrain and block params, a mismatch means the snapshot is stale.
+#define HEXGRID_SNAPSHOT_MAGIC		0x50534748
+#define HEXGRID_SNAPSHOT_VERSION	3
+
+struct FHexGridSnapshotHeader
+{
+	uint32 Magic = HEXGRID_SNAPSHOT_MAGIC;
+	uint32 Version = HEXGRID_SNAPSHOT_VERSION;
+	uint32 Key = 0;
+	int32 TileNum = 0;
+	int32 AreaBlockLevelMax = 0;
+	int32 BuildingBlockLevelMax = 0;
+	int64 TilesOffset = 0;
+	int32 CornerNum = 0;
+	int32 Reserved = 0;
+	int64 CornersOffset = 0;
+};
+
+struct FHexGridSnapshotTile
+{
+	float PositionZ = 0.0f;
+	float AvgPositionZ = 0.0f;
+	float NormalX = 0.0f;
+	float NormalY = 0.0f;
+	float NormalZ = 0.0f;
+	float AngleToUp = 0.0f;
+	int32 AreaBlockLevel = 0;
+	int32 BuildingBlockLevel = 0;
+	uint8 IsLand = 0;
+	uint8 AreaConnection = 0;
+	uint8 Reserved[2] = { 0, 0 };
+};
+
+static_assert(sizeof(FHexGridSnapshotHeader) == 48, "FHexGridSnapshotHeader layout changed.");
+static_assert(sizeof(FHexGridSnapshotTile) == 36, "FHexGridSnapshotTile layout changed.");
@@ -2,21 +2,6 @@
 
 #include "HexGridStructDefine.generated.h"
 
-USTRUCT(BlueprintType)
-struct FStructHexTileNeighbors
-{
-	GENERATED_BODY()
-
-	UPROPERTY()
-	int32 Radius = 0;
-
-	UPROPERTY()
-	int32 Count = 0;
-
-	UPROPERTY()
-	TArray<FIntPoint> Tiles;
-};
-
 USTRUCT(BlueprintType)
 struct FStructHexTileData
 {
@@ -46,9 +31,6 @@ struct FStructHexTileData
 	UPROPERTY(BlueprintReadOnly)
 	float AngleToUp = 0.0;
 
-	UPROPERTY(BlueprintReadOnly)
-	TArray<FStructHexTileNeighbors> Neighbors;
-
 	UPROPERTY(BlueprintReadOnly)
 	int32 TerrainAreaBlockLevel = 0;
 
@@ -2,6 +2,7 @@
 
 
 #include "Terrain.h"
+#include "TerrainBakeFormat.h"
 #include "FlowControlUtility.h"
 
 #include "ProceduralMeshComponent.h"
@@ -9,6 +10,8 @@
 #include "EnhancedInputSubsystems.h"
 #include "Kismet/KismetMaterialLibrary.h"
 #include "Kismet/GameplayStatics.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
 
 DEFINE_LOG_CATEGORY(Terrain);
 
@@ -183,10 +186,12 @@ void ATerrain::InitWorkflow()
 	InitTerrainFormBaseRatio();
 	InitWater();
 	InitTreeParam();
+	InitBakeParamsHash();
 
 	FTimerHandle TimerHandle;
 	if (CheckMaterialSetting()) {
-		WorkflowState = Enum_TerrainWorkflowState::CreateVerticesAndUVs;
+		WorkflowState = bUseBakedData ? Enum_TerrainWorkflowState::LoadBakedData
+			: Enum_TerrainWorkflowState::CreateVerticesAndUVs;
 		UE_LOG(Terrain, Log, TEXT("Init workflow done!"));
 	}
 	else {
@@ -382,6 +387,9 @@ void ATerrain::CreateTerrainFlow()
 	case Enum_TerrainWorkflowState::InitWorkflow:
 		InitWorkflow();
 		break;
+	case Enum_TerrainWorkflowState::LoadBakedData:
+		LoadBakedData();
+		break;
 	case Enum_TerrainWorkflowState::CreateVerticesAndUVs:
 		CreateVertices();
 		break;
@@ -393,6 +401,9 @@ void ATerrain::CreateTerrainFlow()
 	case Enum_TerrainWorkflowState::NormalizeNormals:
 		CreateNormals();
 		break;
+	case Enum_TerrainWorkflowState::SaveBakedData:
+		SaveBakedData();
+		break;
 	case Enum_TerrainWorkflowState::DrawLandMesh:
 		CreateTerrainMesh();
 		SetTerrainMaterial();
@@ -411,6 +422,244 @@ void ATerrain::CreateTerrainFlow()
 	}
 }
 
+void ATerrain::InitBakeParamsHash()
+{
+	uint32 Hash = 0;
+	auto HashValue = [&Hash](const auto& Value)
+		{
+			Hash = FCrc::MemCrc32(&Value, sizeof(Value), Hash);
+		};
+	auto HashMapping = [&HashValue](const FStructHeightMapping& Mapping)
+		{
+			HashValue(Mapping.RangeMin);
+			HashValue(Mapping.RangeMax);
+			HashValue(Mapping.MappingMin);
+			HashValue(Mapping.MappingMax);
+			HashValue(Mapping.RangeMinOffset);
+			HashValue(Mapping.RangeMaxOffset);
+		};
+#define HASH_NOISE_PARAMS(NW) \
+	HashValue(NW##_NoiseType); HashValue(NW##_NoiseSeed); HashValue(NW##_NoiseFrequency); \
+	HashValue(NW##_Interp); HashValue(NW##_FractalType); HashValue(NW##_Octaves); \
+	HashValue(NW##_Lacunarity); HashValue(NW##_Gain); HashValue(NW##_CellularJitter); \
+	HashValue(NW##_CDF); HashValue(NW##_CRT);
+
+	HashValue(TERRAIN_BAKE_DATA_VERSION);
+
+	//Noise
+	HASH_NOISE_PARAMS(NWHighMountain)
+	HASH_NOISE_PARAMS(NWLowMountain)
+	HASH_NOISE_PARAMS(NWWater)
+	HASH_NOISE_PARAMS(NWMoisture)
+	HASH_NOISE_PARAMS(NWTemperature)
+	HASH_NOISE_PARAMS(NWBiomes)
+	HASH_NOISE_PARAMS(NWTree)
+#undef HASH_NOISE_PARAMS
+
+	//Tile
+	HashValue(NumRows);
+	HashValue(NumColumns);
+	HashValue(StdNumRows);
+	HashValue(StdNumColumns);
+	HashValue(TileScale);
+	HashValue(TileSize);
+	HashValue(TileAltitudeMax);
+
+	//Terrain
+	HashValue(HighMountainLevel);
+	HashMapping(HighRangeMapping);
+	HashValue(LowMountainLevel);
+	HashMapping(LowRangeMapping);
+	HashValue(HasWater);
+	HashValue(WaterLevel);
+	HashMapping(WaterRangeMapping);
+	HashValue(WaterBaseRatio);
+	HashValue(WaterBankSharpness);
+
+	//Tree
+	HashValue(TreeAreaScale);
+
+	BakeParamsHash = Hash;
+}
+
+FString ATerrain::GetBakedDataPath()
+{
+	return FPaths::ProjectSavedDir().Append(BakedDataRelPath).Append(BakedDataFileName);
+}
+
+void ATerrain::LoadBakedData()
+{
+	FTimerHandle TimerHandle;
+	if (LoadBakedDataFromFile()) {
+		RebuildUVsAndTriangles();
+		WorkflowState = Enum_TerrainWorkflowState::DrawLandMesh;
+		UE_LOG(Terrain, Log, TEXT("Load baked data done."));
+	}
+	else {
+		Vertices.Empty();
+		Normals.Empty();
+		VertexColors.Empty();
+		TreeValues.Empty();
+		WorkflowState = Enum_TerrainWorkflowState::CreateVerticesAndUVs;
+		UE_LOG(Terrain, Log, TEXT("No valid baked data, create terrain."));
+	}
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+}
+
+bool ATerrain::LoadBakedDataFromFile()
+{
+	FString Path = GetBakedDataPath();
+	if (!FPaths::FileExists(Path)) {
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Path));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion() : nullptr);
+	if (!MappedRegion) {
+		UE_LOG(Terrain, Warning, TEXT("Map baked data file %s failed!"), *Path);
+		return false;
+	}
+	return ParseBakedData(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+}
+
+bool ATerrain::ParseBakedData(const uint8* Data, int64 Size)
+{
+	if (Size < int64(sizeof(FTerrainBakeHeader))) {
+		return false;
+	}
+
+	FTerrainBakeHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(FTerrainBakeHeader));
+	if (Header.Magic != TERRAIN_BAKE_MAGIC || Header.Version != TERRAIN_BAKE_VERSION) {
+		return false;
+	}
+	if (Header.ParamsHash != BakeParamsHash) {
+		UE_LOG(Terrain, Log, TEXT("Baked data is stale, params hash %u does not match %u."), Header.ParamsHash, BakeParamsHash);
+		return false;
+	}
+
+	int64 VertexNum = Header.VertexNum;
+	if (Header.NumRows != NumRows || Header.NumColumns != NumColumns
+		|| VertexNum != int64(NumRows + 1) * (NumColumns + 1)) {
+		return false;
+	}
+
+	//Tables must lie after the header, inside the file and on 4 byte alignment, end is compared without overflow
+	auto IsTableValid = [Size, VertexNum](int64 Offset, int64 ElementSize)
+		{
+			return Offset >= int64(sizeof(FTerrainBakeHeader)) && Offset % 4 == 0 && Offset <= Size
+				&& VertexNum <= (Size - Offset) / ElementSize;
+		};
+	if (!IsTableValid(Header.VerticesOffset, sizeof(FVector3f))
+		|| !IsTableValid(Header.NormalsOffset, sizeof(FVector3f))
+		|| !IsTableValid(Header.VertexColorsOffset, sizeof(FLinearColor))
+		|| !IsTableValid(Header.TreeValuesOffset, sizeof(float))) {
+		return false;
+	}
+
+	const FVector3f* VerticesData = reinterpret_cast<const FVector3f*>(Data + Header.VerticesOffset);
+	const FVector3f* NormalsData = reinterpret_cast<const FVector3f*>(Data + Header.NormalsOffset);
+	Vertices.SetNumUninitialized(Header.VertexNum);
+	Normals.SetNumUninitialized(Header.VertexNum);
+	for (int32 i = 0; i < Header.VertexNum; i++)
+	{
+		Vertices[i] = FVector(VerticesData[i]);
+		Normals[i] = FVector(NormalsData[i]);
+	}
+
+	VertexColors.SetNumUninitialized(Header.VertexNum);
+	FMemory::Memcpy(VertexColors.GetData(), Data + Header.VertexColorsOffset, VertexNum * sizeof(FLinearColor));
+	TreeValues.SetNumUninitialized(Header.VertexNum);
+	FMemory::Memcpy(TreeValues.GetData(), Data + Header.TreeValuesOffset, VertexNum * sizeof(float));
+	return true;
+}
+
+void ATerrain::RebuildUVsAndTriangles()
+{
+	int32 HalfRow = NumRows * 0.5;
+	int32 HalfColumn = NumColumns * 0.5;
+	int32 ColumnVertexNum = NumColumns + 1;
+
+	UVs.Empty(Vertices.Num());
+	UV1.Empty(Vertices.Num());
+	for (int32 i = 0; i <= NumRows; i++) {
+		for (int32 j = 0; j <= NumColumns; j++) {
+			CreateUV(i - HalfRow, j - HalfColumn);
+		}
+	}
+
+	Triangles.Empty(NumRows * NumColumns * 6);
+	for (int32 i = 0; i < NumRows; i++) {
+		for (int32 j = 0; j < NumColumns; j++) {
+			CreatePairTriangles(j, i * ColumnVertexNum, (i + 1) * ColumnVertexNum);
+		}
+	}
+}
+
+void ATerrain::SaveBakedData()
+{
+	if (SaveBakedDataToFile()) {
+		UE_LOG(Terrain, Log, TEXT("Save baked data done."));
+	}
+	else {
+		UE_LOG(Terrain, Warning, TEXT("Save baked data to %s failed!"), *GetBakedDataPath());
+	}
+
+	FTimerHandle TimerHandle;
+	WorkflowState = Enum_TerrainWorkflowState::DrawLandMesh;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+}
+
+bool ATerrain::SaveBakedDataToFile()
+{
+	int32 VertexNum = Vertices.Num();
+	if (Normals.Num() != VertexNum || VertexColors.Num() != VertexNum || TreeValues.Num() != VertexNum) {
+		return false;
+	}
+
+	FTerrainBakeHeader Header;
+	Header.ParamsHash = BakeParamsHash;
+	Header.NumRows = NumRows;
+	Header.NumColumns = NumColumns;
+	Header.VertexNum = VertexNum;
+	Header.VerticesOffset = sizeof(FTerrainBakeHeader);
+	Header.NormalsOffset = Header.VerticesOffset + int64(VertexNum) * sizeof(FVector3f);
+	Header.VertexColorsOffset = Header.NormalsOffset + int64(VertexNum) * sizeof(FVector3f);
+	Header.TreeValuesOffset = Header.VertexColorsOffset + int64(VertexNum) * sizeof(FLinearColor);
+
+	TArray<FVector3f> VerticesData;
+	TArray<FVector3f> NormalsData;
+	VerticesData.SetNumUninitialized(VertexNum);
+	NormalsData.SetNumUninitialized(VertexNum);
+	for (int32 i = 0; i < VertexNum; i++)
+	{
+		VerticesData[i] = FVector3f(Vertices[i]);
+		NormalsData[i] = FVector3f(Normals[i]);
+	}
+
+	FString Path = GetBakedDataPath();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*Path));
+	if (!FileHandle) {
+		return false;
+	}
+
+	bool bWritten = FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(FTerrainBakeHeader))
+		&& FileHandle->Write(reinterpret_cast<const uint8*>(VerticesData.GetData()), int64(VertexNum) * sizeof(FVector3f))
+		&& FileHandle->Write(reinterpret_cast<const uint8*>(NormalsData.GetData()), int64(VertexNum) * sizeof(FVector3f))
+		&& FileHandle->Write(reinterpret_cast<const uint8*>(VertexColors.GetData()), int64(VertexNum) * sizeof(FLinearColor))
+		&& FileHandle->Write(reinterpret_cast<const uint8*>(TreeValues.GetData()), int64(VertexNum) * sizeof(float));
+	FileHandle.Reset();
+
+	//Never leave a partial file behind, it would be rejected on load anyway
+	if (!bWritten) {
+		PlatformFile.DeleteFile(*Path);
+	}
+	return bWritten;
+}
+
 void ATerrain::ResetProgress()
 {
 	ProgressTarget = MAX_int32;
@@ -797,7 +1046,8 @@ void ATerrain::NormalizeNormals()
 	}
 	ResetProgress();
 
-	WorkflowState = Enum_TerrainWorkflowState::DrawLandMesh;
+	WorkflowState = bUseBakedData ? Enum_TerrainWorkflowState::SaveBakedData
+		: Enum_TerrainWorkflowState::DrawLandMesh;
 	FTimerHandle TimerHandle;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, NormalizeNormalsLoopData.Rate, false);
 	UE_LOG(Terrain, Log, TEXT("Normalize normals done."));
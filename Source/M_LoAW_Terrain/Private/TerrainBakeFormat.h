@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Baked terrain written and memory-mapped by ATerrain.
+//Layout: Header | Vertices[VertexNum] | Normals[VertexNum] | VertexColors[VertexNum] | TreeValues[VertexNum]
+//UVs and triangles only depend on tile counts and are rebuilt on load.
+#define TERRAIN_BAKE_MAGIC		0x4B425254
+#define TERRAIN_BAKE_VERSION	1
+
+//Version of baked content, bump when vertex generation changes for the same params
+#define TERRAIN_BAKE_DATA_VERSION	1
+
+struct FTerrainBakeHeader
+{
+	uint32 Magic = TERRAIN_BAKE_MAGIC;
+	uint32 Version = TERRAIN_BAKE_VERSION;
+	uint32 ParamsHash = 0;
+	int32 NumRows = 0;
+	int32 NumColumns = 0;
+	int32 VertexNum = 0;
+	int64 VerticesOffset = 0;
+	int64 NormalsOffset = 0;
+	int64 VertexColorsOffset = 0;
+	int64 TreeValuesOffset = 0;
+};
+
+static_assert(sizeof(FTerrainBakeHeader) == 56, "FTerrainBakeHeader layout changed.");
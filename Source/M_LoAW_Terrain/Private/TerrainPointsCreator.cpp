@@ -4,9 +4,6 @@
 #include "TerrainPointsCreator.h"
 #include "FlowControlUtility.h"
 
-//#include <iostream>
-#include <fstream>
-
 DEFINE_LOG_CATEGORY(TerrainPointsCreator);
 
 ATerrainPointsCreator::ATerrainPointsCreator()
@@ -17,12 +14,130 @@ void ATerrainPointsCreator::CreateData()
 {
 	if (IsInWorkingState()) return;
 
+	if (!bForceRecreate && IsCachedDataValid()) {
+		UE_LOG(TerrainPointsCreator, Log, TEXT("Terrain points data is up to date, skip creating."));
+		return;
+	}
+
 	UE_LOG(TerrainPointsCreator, Log, TEXT("ATerrainPointsCreator::CreateData()."));
+	if (!InitResume()) {
+		InitIncrementalWrite();
+	}
+	InvalidateParams(DataFileRelPath + ParamsDataFileName);
 	BindDelegate();
 	WorkflowState = Enum_TerrainPointsCreatorWorkflowState::InitWorkflow;
 	CreateTerrainPointsFlow();
 }
 
+uint32 ATerrainPointsCreator::CalParamsHash(int32 InGridRange, int32 InNeighborRange)
+{
+	int32 Params[3] = { TERRAIN_POINTS_DATA_VERSION, InGridRange, InNeighborRange };
+	return FCrc::MemCrc32(Params, sizeof(Params));
+}
+
+bool ATerrainPointsCreator::IsCachedDataValid()
+{
+	TArray<FString> DataRelPaths = { DataFileRelPath + PointsDataFileName, DataFileRelPath + PointIndicesDataFileName };
+	for (int32 i = 1; i <= NeighborRange; i++)
+	{
+		FString NeighborPath;
+		CreateNeighborPath(NeighborPath, i);
+		DataRelPaths.Add(NeighborPath);
+	}
+	return IsDataUpToDate(DataFileRelPath + ParamsDataFileName, DataRelPaths, CalParamsHash(GridRange, NeighborRange));
+}
+
+void ATerrainPointsCreator::InitIncrementalWrite()
+{
+	//Points and neighbor files only depend on GridRange, a new NeighborRange with the same
+	//GridRange only needs the missing neighbor radii
+	bWritePointsData = true;
+	NeighborBegin = 1;
+	if (bForceRecreate) {
+		return;
+	}
+
+	TArray<FString> OldParams;
+	uint32 OldHash;
+	int32 OldGridRange, OldNeighborRange;
+	if (!ReadParams(DataFileRelPath + ParamsDataFileName, OldParams, OldHash) || OldParams.Num() != 2
+		|| !LexTryParseString(OldGridRange, *OldParams[0])
+		|| !LexTryParseString(OldNeighborRange, *OldParams[1])) {
+		return;
+	}
+
+	if (OldHash != CalParamsHash(OldGridRange, OldNeighborRange) || OldGridRange != GridRange) {
+		return;
+	}
+
+	TArray<FString> DataRelPaths = { DataFileRelPath + PointsDataFileName, DataFileRelPath + PointIndicesDataFileName };
+	for (int32 i = 1; i <= FMath::Min(OldNeighborRange, NeighborRange); i++)
+	{
+		FString NeighborPath;
+		CreateNeighborPath(NeighborPath, i);
+		DataRelPaths.Add(NeighborPath);
+	}
+	for (const FString& RelPath : DataRelPaths)
+	{
+		if (!FPaths::FileExists(FPaths::ProjectDir().Append(RelPath))) {
+			return;
+		}
+	}
+
+	bWritePointsData = false;
+	NeighborBegin = OldNeighborRange + 1;
+	UE_LOG(TerrainPointsCreator, Log, TEXT("Reuse points data and neighbors N1 to N%d."), FMath::Min(OldNeighborRange, NeighborRange));
+}
+
+bool ATerrainPointsCreator::InitResume()
+{
+	FString CheckpointRelPath = DataFileRelPath + CheckpointFileName;
+	if (bForceRecreate || !bStreamCreate || !LoadCheckpoint(CheckpointRelPath, CalParamsHash(GridRange, NeighborRange))
+		|| Checkpoint.Stage != int32(Enum_TerrainPointsCreatorWorkflowState::StreamCreate)
+		|| Checkpoint.Values.Num() != 2 || Checkpoint.LoopIndices.Num() != 3) {
+		DeleteCheckpoint(CheckpointRelPath);
+		return false;
+	}
+
+	//Reopen the same set of files as the interrupted run
+	bWritePointsData = Checkpoint.Values[0] != 0;
+	NeighborBegin = Checkpoint.Values[1];
+	return true;
+}
+
+void ATerrainPointsCreator::SaveStreamCheckpoint()
+{
+	if (!IsCheckpointDue()) {
+		return;
+	}
+
+	FDataCreatorCheckpoint Data;
+	Data.ParamsHash = CalParamsHash(GridRange, NeighborRange);
+	Data.Stage = int32(Enum_TerrainPointsCreatorWorkflowState::StreamCreate);
+	Data.LoopCount = StreamCreateLoopData.Count;
+	Data.LoopIndices = { StreamCreateLoopData.IndexSaved[0], StreamCreateLoopData.IndexSaved[1], StreamCreateLoopData.IndexSaved[2] };
+	Data.Values = { bWritePointsData ? 1 : 0, NeighborBegin };
+	for (int32 i = 0; i < StreamWriters.Num(); i++)
+	{
+		if (!StreamWriters[i]->Flush()) {
+			return;
+		}
+		Data.FileSizes.Add(StreamWriters[i]->Tell());
+	}
+
+	if (bWritePointsData) {
+		Data.FileRelPaths.Add(DataFileRelPath + PointsDataFileName);
+		Data.FileRelPaths.Add(DataFileRelPath + PointIndicesDataFileName);
+	}
+	for (int32 i = NeighborBegin; i <= NeighborRange; i++)
+	{
+		FString NeighborPath;
+		CreateNeighborPath(NeighborPath, i);
+		Data.FileRelPaths.Add(NeighborPath);
+	}
+	SaveCheckpoint(DataFileRelPath + CheckpointFileName, Data);
+}
+
 void ATerrainPointsCreator::BindDelegate()
 {
 	WorkflowDelegate.BindUFunction(Cast<UObject>(this), TEXT("CreateTerrainPointsFlow"));
@@ -35,6 +150,9 @@ void ATerrainPointsCreator::CreateTerrainPointsFlow()
 	case Enum_TerrainPointsCreatorWorkflowState::InitWorkflow:
 		InitWorkflow();
 		break;
+	case Enum_TerrainPointsCreatorWorkflowState::StreamCreate:
+		StreamCreate();
+		break;
 	case Enum_TerrainPointsCreatorWorkflowState::SpiralCreateCenter:
 		SpiralCreateCenter();
 		break;
@@ -69,20 +187,30 @@ void ATerrainPointsCreator::InitWorkflow()
 	InitLoopData();
 
 	FTimerHandle TimerHandle;
-	WorkflowState = Enum_TerrainPointsCreatorWorkflowState::SpiralCreateCenter;
+	WorkflowState = bStreamCreate ? Enum_TerrainPointsCreatorWorkflowState::StreamCreate
+		: Enum_TerrainPointsCreatorWorkflowState::SpiralCreateCenter;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 	UE_LOG(TerrainPointsCreator, Log, TEXT("Init workflow done."));
 }
 
 void ATerrainPointsCreator::InitLoopData()
 {
+	FlowControlUtility::InitLoopData(StreamCreateLoopData);
+	StreamCreateLoopData.IndexSaved[0] = 1;
+	if (bResumeCheckpoint) {
+		for (int32 i = 0; i < Checkpoint.LoopIndices.Num(); i++)
+		{
+			StreamCreateLoopData.IndexSaved[i] = Checkpoint.LoopIndices[i];
+		}
+		StreamCreateLoopData.Count = Checkpoint.LoopCount;
+	}
 	FlowControlUtility::InitLoopData(SpiralCreateCenterLoopData);
 	SpiralCreateCenterLoopData.IndexSaved[0] = 1;
 	FlowControlUtility::InitLoopData(SpiralCreateNeighborsLoopData);
 	SpiralCreateNeighborsLoopData.IndexSaved[1] = 1;
 	FlowControlUtility::InitLoopData(WritePointsLoopData);
 	FlowControlUtility::InitLoopData(WriteNeighborsLoopData);
-	WriteNeighborsLoopData.IndexSaved[0] = 1;
+	WriteNeighborsLoopData.IndexSaved[0] = NeighborBegin;
 	FlowControlUtility::InitLoopData(WritePointIndicesLoopData);
 }
 
@@ -92,6 +220,170 @@ void ATerrainPointsCreator::ResetProgress()
 	ProgressCurrent = 0;
 }
 
+void ATerrainPointsCreator::StreamCreate()
+{
+	bool OnceLoop0 = true;
+	bool OnceLoop1 = true;
+	int32 Count = 0;
+	TArray<int32> Indices = { 0, 0, 0 };
+	bool SaveLoopFlag = false;
+
+	FTimerHandle TimerHandle;
+	if (!StreamCreateLoopData.HasInitialized) {
+		StreamCreateLoopData.HasInitialized = true;
+		bool bResume = bResumeCheckpoint;
+		bResumeCheckpoint = false;
+		if (bResume && !OpenStreamWriters(true)) {
+			//Same as an unusable checkpoint, the same files are written again from the first point
+			UE_LOG(TerrainPointsCreator, Warning, TEXT("Resume stream data failed, write it from the beginning."));
+			CloseStreamWriters();
+			DeleteCheckpoint(DataFileRelPath + CheckpointFileName);
+			FlowControlUtility::InitLoopData(StreamCreateLoopData);
+			StreamCreateLoopData.HasInitialized = true;
+			StreamCreateLoopData.IndexSaved[0] = 1;
+			bResume = false;
+		}
+		if (!bResume && !OpenStreamWriters(false)) {
+			CloseStreamWriters();
+			WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
+			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, StreamCreateLoopData.Rate, false);
+			return;
+		}
+		if (StreamWriters.Num() == 0) {
+			WorkflowState = Enum_TerrainPointsCreatorWorkflowState::WriteParams;
+			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, StreamCreateLoopData.Rate, false);
+			UE_LOG(TerrainPointsCreator, Log, TEXT("Points data is up to date, skip stream create."));
+			return;
+		}
+		//On resume the center point is already in the files
+		if (!bResume) {
+			WriteStreamPoint(FIntPoint(0, 0), 0);
+		}
+		ProgressTarget = FQuadGridSpiral::PointNum(GridRange) - 1;
+	}
+
+	int32 i = StreamCreateLoopData.IndexSaved[0];
+	i = i < 1 ? 1 : i;
+	int32 j, k;
+
+	for (; i <= GridRange; i++)
+	{
+		Indices[0] = i;
+		int32 RingBegin = FQuadGridSpiral::RingBegin(i);
+		j = OnceLoop0 ? StreamCreateLoopData.IndexSaved[1] : 0;
+		for (; j < FQuadGridSpiral::SideNum; j++) {
+			Indices[1] = j;
+			k = OnceLoop1 ? StreamCreateLoopData.IndexSaved[2] : 0;
+			for (; k <= i - 1; k++) {
+				Indices[2] = k;
+				FlowControlUtility::SaveLoopData(this, StreamCreateLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
+				if (SaveLoopFlag) {
+					SaveStreamCheckpoint();
+					return;
+				}
+				WriteStreamPoint(FQuadGridSpiral::RingPoint(i, j, k), RingBegin + j * i + k);
+
+				ProgressCurrent = StreamCreateLoopData.Count;
+				Count++;
+			}
+			OnceLoop1 = false;
+		}
+		OnceLoop0 = false;
+	}
+	ResetProgress();
+
+	if (!CloseStreamWriters()) {
+		UE_LOG(TerrainPointsCreator, Warning, TEXT("Write stream data failed!"));
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, StreamCreateLoopData.Rate, false);
+		return;
+	}
+	DeleteCheckpoint(DataFileRelPath + CheckpointFileName);
+
+	WorkflowState = Enum_TerrainPointsCreatorWorkflowState::WriteParams;
+	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, StreamCreateLoopData.Rate, false);
+	UE_LOG(TerrainPointsCreator, Log, TEXT("Stream create done."));
+}
+
+bool ATerrainPointsCreator::OpenStreamWriters(bool bResume)
+{
+	TArray<FString> RelPaths;
+	if (bWritePointsData) {
+		RelPaths.Add(DataFileRelPath + PointsDataFileName);
+		RelPaths.Add(DataFileRelPath + PointIndicesDataFileName);
+	}
+	StreamNeighborWriterBegin = RelPaths.Num();
+	for (int32 i = NeighborBegin; i <= NeighborRange; i++)
+	{
+		FString NeighborPath;
+		CreateNeighborPath(NeighborPath, i);
+		RelPaths.Add(NeighborPath);
+	}
+
+	StreamWriters.Empty(RelPaths.Num());
+	for (const FString& RelPath : RelPaths)
+	{
+		FString FullPath;
+		CreateFilePath(RelPath, FullPath);
+		TUniquePtr<FBufferedDataWriter>& Writer = StreamWriters.Add_GetRef(MakeUnique<FBufferedDataWriter>(StreamBufferSize));
+		bool bOpened = bResume ? ResumeDataWriter(*Writer, FullPath, Checkpoint.FindFileSize(RelPath))
+			: OpenDataWriter(*Writer, FullPath);
+		if (!bOpened) {
+			UE_LOG(TerrainPointsCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ATerrainPointsCreator::CloseStreamWriters()
+{
+	bool bClosed = true;
+	for (TUniquePtr<FBufferedDataWriter>& Writer : StreamWriters)
+	{
+		if (Writer->IsOpen() && !Writer->Close()) {
+			bClosed = false;
+		}
+	}
+	StreamWriters.Empty();
+	return bClosed;
+}
+
+void ATerrainPointsCreator::WriteStreamPoint(const FIntPoint& Coord, int32 Index)
+{
+	if (bWritePointsData) {
+		FBufferedDataWriter& PointsWriter = *StreamWriters[0];
+		WriteIndicesKey(PointsWriter, Coord);
+		WriteLineEnd(PointsWriter);
+
+		FBufferedDataWriter& IndicesWriter = *StreamWriters[1];
+		WriteIndicesKey(IndicesWriter, Coord);
+		WritePipeDelimiter(IndicesWriter);
+		WriteIndicesValue(IndicesWriter, Index);
+		WriteLineEnd(IndicesWriter);
+	}
+
+	for (int32 i = NeighborBegin; i <= NeighborRange; i++)
+	{
+		WriteStreamNeighborLine(*StreamWriters[StreamNeighborWriterBegin + i - NeighborBegin], Coord, i);
+	}
+}
+
+void ATerrainPointsCreator::WriteStreamNeighborLine(FBufferedDataWriter& Writer, const FIntPoint& Center, int32 Radius)
+{
+	//Same walk as SpiralCreateNeighbors, start at Radius * start direction and follow each diagonal
+	FQuadGridSpiral::ForEachRingPoint(Center, Radius, [this, &Writer](const FIntPoint& Coord, int32 Side, int32 Step)
+		{
+			if (Side != 0 || Step != 0) {
+				WriteSpaceDelimiter(Writer);
+			}
+			Writer.WriteInt(Coord.X);
+			WriteCommaDelimiter(Writer);
+			Writer.WriteInt(Coord.Y);
+		});
+	WriteLineEnd(Writer);
+}
+
 void ATerrainPointsCreator::SpiralCreateCenter()
 {
 	bool OnceLoop0 = true;
@@ -102,27 +394,20 @@ void ATerrainPointsCreator::SpiralCreateCenter()
 
 	if (!SpiralCreateCenterLoopData.HasInitialized) {
 		SpiralCreateCenterLoopData.HasInitialized = true;
-		RingInitFlag = false;
 		InitGridCenter();
-		ProgressTarget = NeighborStep * (1 + GridRange) * GridRange / 2;
+		ProgressTarget = FQuadGridSpiral::PointNum(GridRange) - 1;
 	}
 
 	int32 i = SpiralCreateCenterLoopData.IndexSaved[0];
 	i = i < 1 ? 1 : i;
 	int32 j, k;
 
+	//Ring i, side j, step k of the shared quad spiral, same order as StreamCreate
 	for (; i <= GridRange; i++)
 	{
 		Indices[0] = i;
-		if (!RingInitFlag) {
-			RingInitFlag = true;
-			Quad quad = Quad::NeighborDirection(TERRAIN_POINTS_RING_START_DIRECTION_INDEX);
-			quad = Quad::Scale(quad, i);
-			TmpQuad = Quad::Add(quad, Quad(Points[0].AxialCoord));
-		}
-
 		j = OnceLoop0 ? SpiralCreateCenterLoopData.IndexSaved[1] : 0;
-		for (; j < NeighborStep; j++) {
+		for (; j < FQuadGridSpiral::SideNum; j++) {
 			Indices[1] = j;
 			k = OnceLoop1 ? SpiralCreateCenterLoopData.IndexSaved[2] : 0;
 			for (; k <= i - 1; k++) {
@@ -131,15 +416,13 @@ void ATerrainPointsCreator::SpiralCreateCenter()
 				if (SaveLoopFlag) {
 					return;
 				}
-				AddRingPointAndIndex();
-				FindNeighborPointOfRing(j);
+				AddRingPoint(FQuadGridSpiral::RingPoint(i, j, k));
 
 				ProgressCurrent = SpiralCreateCenterLoopData.Count;
 				Count++;
 			}
 			OnceLoop1 = false;
 		}
-		RingInitFlag = false;
 		OnceLoop0 = false;
 	}
 	ResetProgress();
@@ -162,19 +445,13 @@ void ATerrainPointsCreator::InitGridCenter()
 	PointIndices.Add(Data.AxialCoord, 0);
 }
 
-void ATerrainPointsCreator::AddRingPointAndIndex()
+void ATerrainPointsCreator::AddRingPoint(const FIntPoint& AxialCoord)
 {
 	FStructTerrainPointData Data;
-	Data.AxialCoord.X = TmpQuad.GetCoord().X;
-	Data.AxialCoord.Y = TmpQuad.GetCoord().Y;
+	Data.AxialCoord = AxialCoord;
 	int32 Index = Points.Add(Data);
 
-	PointIndices.Add(FIntPoint(Data.AxialCoord.X, Data.AxialCoord.Y), Index);
-}
-
-void ATerrainPointsCreator::FindNeighborPointOfRing(int32 DirIndex)
-{
-	TmpQuad = Quad::Neighbor(TmpQuad, DirIndex);
+	PointIndices.Add(AxialCoord, Index);
 }
 
 void ATerrainPointsCreator::SpiralCreateNeighbors()
@@ -188,33 +465,27 @@ void ATerrainPointsCreator::SpiralCreateNeighbors()
 
 	if (!SpiralCreateNeighborsLoopData.HasInitialized) {
 		SpiralCreateNeighborsLoopData.HasInitialized = true;
-		RingInitFlag = false;
-		ProgressTarget = Points.Num() * NeighborStep * (1 + NeighborRange) * NeighborRange / 2;
+		ProgressTarget = Points.Num() * (FQuadGridSpiral::PointNum(NeighborRange) - 1);
 	}
 
 	int32 PointIndex = SpiralCreateNeighborsLoopData.IndexSaved[0];
 	int32 i, j, k;
-	Quad center;
 
 	for (; PointIndex < Points.Num(); PointIndex++)
 	{
 		Indices[0] = PointIndex;
-		center.SetAxialInt(Points[PointIndex].AxialCoord);
+		const FIntPoint Center = Points[PointIndex].AxialCoord;
 		i = OnceLoop0 ? SpiralCreateNeighborsLoopData.IndexSaved[1] : 1;
 		i = i < 1 ? 1 : i;
 		for (; i <= NeighborRange; i++) {
 			Indices[1] = i;
-			if (!RingInitFlag) {
-				RingInitFlag = true;
+			//Ring list is added once, also when a saved loop resumes inside the ring
+			if (Points[PointIndex].Neighbors.Num() < i) {
 				AddPointNeighbor(PointIndex, i);
-
-				Quad quad = Quad::NeighborDirection(TERRAIN_POINTS_RING_START_DIRECTION_INDEX);
-				quad = Quad::Scale(quad, i);
-				TmpQuad = Quad::Add(quad, center);
 			}
 
 			j = OnceLoop1 ? SpiralCreateNeighborsLoopData.IndexSaved[2] : 0;
-			for (; j < NeighborStep; j++) {
+			for (; j < FQuadGridSpiral::SideNum; j++) {
 				Indices[2] = j;
 				k = OnceLoop2 ? SpiralCreateNeighborsLoopData.IndexSaved[3] : 0;
 				for (; k <= i - 1; k++) {
@@ -223,13 +494,12 @@ void ATerrainPointsCreator::SpiralCreateNeighbors()
 					if (SaveLoopFlag) {
 						return;
 					}
-					SetPointNeighbor(PointIndex, i, j);
+					SetPointNeighbor(PointIndex, i, Center + FQuadGridSpiral::RingPoint(i, j, k));
 					ProgressCurrent = SpiralCreateNeighborsLoopData.Count;
 					Count++;
 				}
 				OnceLoop2 = false;
 			}
-			RingInitFlag = false;
 			OnceLoop1 = false;
 		}
 		OnceLoop0 = false;
@@ -249,10 +519,9 @@ void ATerrainPointsCreator::AddPointNeighbor(int32 PointIndex, int32 Radius)
 	Points[PointIndex].Neighbors.Add(neighbors);
 }
 
-void ATerrainPointsCreator::SetPointNeighbor(int32 PointIndex, int32 Radius, int32 DirIndex)
+void ATerrainPointsCreator::SetPointNeighbor(int32 PointIndex, int32 Radius, const FIntPoint& Coord)
 {
-	Points[PointIndex].Neighbors[Radius - 1].Points.Add(FIntPoint(TmpQuad.GetCoord().X, TmpQuad.GetCoord().Y));
-	FindNeighborPointOfRing(DirIndex);
+	Points[PointIndex].Neighbors[Radius - 1].Points.Add(Coord);
 }
 
 void ATerrainPointsCreator::WritePointsToFile()
@@ -263,27 +532,30 @@ void ATerrainPointsCreator::WritePointsToFile()
 	CreateFilePath(PointsDataPath, FullPath);
 
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
+	if (!bWritePointsData) {
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::WritePointsNeighbor;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointsLoopData.Rate, false);
+		UE_LOG(TerrainPointsCreator, Log, TEXT("Points data is up to date, skip writing."));
+		return;
+	}
+
 	if (!WritePointsLoopData.HasInitialized) {
 		WritePointsLoopData.HasInitialized = true;
-		ofs.open(*FullPath, std::ios::out | std::ios::trunc);
+		OpenDataWriter(FullPath);
 		ProgressTarget = Points.Num();
 	}
-	else {
-		ofs.open(*FullPath, std::ios::out | std::ios::app);
-	}
 
-	if (!ofs || !ofs.is_open()) {
+	if (!DataWriter.IsOpen()) {
 		UE_LOG(TerrainPointsCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
 		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
 		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointsLoopData.Rate, false);
 		return;
 	}
 
-	WritePoints(ofs);
+	WritePoints(DataWriter);
 }
 
-void ATerrainPointsCreator::WritePoints(std::ofstream& ofs)
+void ATerrainPointsCreator::WritePoints(FBufferedDataWriter& Writer)
 {
 	int32 Count = 0;
 	TArray<int32> Indices = { 0 };
@@ -295,41 +567,42 @@ void ATerrainPointsCreator::WritePoints(std::ofstream& ofs)
 		Indices[0] = i;
 		FlowControlUtility::SaveLoopData(this, WritePointsLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
 		if (SaveLoopFlag) {
-			ofs.close();
 			return;
 		}
-		WritePointLine(ofs, i);
+		WritePointLine(Writer, i);
 		ProgressCurrent = WritePointsLoopData.Count;
 		Count++;
 	}
-	ofs.close();
 	FTimerHandle TimerHandle;
+	if (!Writer.Close()) {
+		UE_LOG(TerrainPointsCreator, Warning, TEXT("Write points failed!"));
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointsLoopData.Rate, false);
+		return;
+	}
+
 	WorkflowState = Enum_TerrainPointsCreatorWorkflowState::WritePointsNeighbor;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointsLoopData.Rate, false);
 	UE_LOG(TerrainPointsCreator, Log, TEXT("Write points done."));
 }
 
-void ATerrainPointsCreator::WritePointLine(std::ofstream& ofs, int32 Index)
+void ATerrainPointsCreator::WritePointLine(FBufferedDataWriter& Writer, int32 Index)
 {
-	FStructTerrainPointData Data = Points[Index];
-	WriteAxialCoord(ofs, Data);
-	WriteLineEnd(ofs);
+	WriteAxialCoord(Writer, Points[Index]);
+	WriteLineEnd(Writer);
 }
 
-void ATerrainPointsCreator::WriteAxialCoord(std::ofstream& ofs, const FStructTerrainPointData& Data)
+void ATerrainPointsCreator::WriteAxialCoord(FBufferedDataWriter& Writer, const FStructTerrainPointData& Data)
 {
-	FIntPoint AC = Data.AxialCoord;
-	FString Str = FString::FromInt(AC.X);
-	Str.Append(*CommaDelim);
-	Str.Append(FString::FromInt(AC.Y));
-	ofs << TCHAR_TO_ANSI(*Str);
+	Writer.WriteInt(Data.AxialCoord.X);
+	WriteCommaDelimiter(Writer);
+	Writer.WriteInt(Data.AxialCoord.Y);
 }
 
 void ATerrainPointsCreator::WriteNeighborsToFile()
 {
 	int32 i = WriteNeighborsLoopData.IndexSaved[0];
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
 	ProgressTarget = Points.Num() * CalNeighborsWeight(NeighborRange);
 
 	for (; i <= NeighborRange; i++)
@@ -341,19 +614,16 @@ void ATerrainPointsCreator::WriteNeighborsToFile()
 
 		if (!WriteNeighborsLoopData.HasInitialized) {
 			WriteNeighborsLoopData.HasInitialized = true;
-			ofs.open(*FullPath, std::ios::out | std::ios::trunc);
-		}
-		else {
-			ofs.open(*FullPath, std::ios::out | std::ios::app);
+			OpenDataWriter(FullPath);
 		}
 
-		if (!ofs || !ofs.is_open()) {
+		if (!DataWriter.IsOpen()) {
 			UE_LOG(TerrainPointsCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
 			WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
 			GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteNeighborsLoopData.Rate, false);
 			return;
 		}
-		if (!WriteNeighbors(ofs, i)) {
+		if (!WriteNeighbors(DataWriter, i)) {
 			return;
 		}
 	}
@@ -368,7 +638,7 @@ int32 ATerrainPointsCreator::CalNeighborsWeight(int32 Range)
 	int32 weight = 0;
 	for (int32 i = 1; i <= Range; i++)
 	{
-		weight += i * NeighborStep;
+		weight += i * FQuadGridSpiral::SideNum;
 	}
 	return weight;
 }
@@ -380,49 +650,54 @@ void ATerrainPointsCreator::CreateNeighborPath(FString& NeighborPath, int32 Radi
 	NeighborPath.Append(TilesNeighborPathPrefix).Append(FString::FromInt(Radius)).Append(FString(TEXT(".data")));
 }
 
-bool ATerrainPointsCreator::WriteNeighbors(std::ofstream& ofs, int32 Radius)
+bool ATerrainPointsCreator::WriteNeighbors(FBufferedDataWriter& Writer, int32 Radius)
 {
 	int32 Count = 0;
 	TArray<int32> Indices = { Radius, 0 };
 	bool SaveLoopFlag = false;
 
 	int32 ProgressPre = Points.Num() * CalNeighborsWeight(Radius - 1);
-	int32 ProgressRatio = Radius * NeighborStep;
+	int32 ProgressRatio = Radius * FQuadGridSpiral::SideNum;
 	int32 i = WriteNeighborsLoopData.IndexSaved[1];
 	for (; i <= Points.Num() - 1; i++)
 	{
 		Indices[1] = i;
 		FlowControlUtility::SaveLoopData(this, WriteNeighborsLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
 		if (SaveLoopFlag) {
-			ofs.close();
 			return false;
 		}
-		WriteNeighborLine(ofs, i, Radius);
+		WriteNeighborLine(Writer, i, Radius);
 		ProgressCurrent = ProgressPre + WriteNeighborsLoopData.Count * ProgressRatio;
 		Count++;
 	}
 
-	ofs.close();
+	if (!Writer.Close()) {
+		UE_LOG(TerrainPointsCreator, Warning, TEXT("Write neighbor N%d failed!"), Radius);
+		FTimerHandle TimerHandle;
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WriteNeighborsLoopData.Rate, false);
+		return false;
+	}
+
 	FlowControlUtility::InitLoopData(WriteNeighborsLoopData);
 	WriteNeighborsLoopData.IndexSaved[0] = Radius;
 	UE_LOG(TerrainPointsCreator, Log, TEXT("Write neighbor N%d done."), Radius);
 	return true;
 }
 
-void ATerrainPointsCreator::WriteNeighborLine(std::ofstream& ofs, int32 Index, int32 Radius)
+void ATerrainPointsCreator::WriteNeighborLine(FBufferedDataWriter& Writer, int32 Index, int32 Radius)
 {
-	FStructTerrainPointNeighbors Neighbors = Points[Index].Neighbors[Radius - 1];
+	const FStructTerrainPointNeighbors& Neighbors = Points[Index].Neighbors[Radius - 1];
 	for (int32 i = 0; i < Neighbors.Points.Num(); i++)
 	{
-		FString Str = FString::FromInt(Neighbors.Points[i].X);
-		Str.Append(*CommaDelim);
-		Str.Append(FString::FromInt(Neighbors.Points[i].Y));
+		Writer.WriteInt(Neighbors.Points[i].X);
+		WriteCommaDelimiter(Writer);
+		Writer.WriteInt(Neighbors.Points[i].Y);
 		if (i != Neighbors.Points.Num() - 1) {
-			Str.Append(*SpaceDelim);
+			WriteSpaceDelimiter(Writer);
 		}
-		ofs << TCHAR_TO_ANSI(*Str);
 	}
-	WriteLineEnd(ofs);
+	WriteLineEnd(Writer);
 }
 
 void ATerrainPointsCreator::WritePointIndicesToFile()
@@ -433,26 +708,29 @@ void ATerrainPointsCreator::WritePointIndicesToFile()
 	CreateFilePath(PointIndicesDataPath, FullPath);
 
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
+	if (!bWritePointsData) {
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::WriteParams;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointIndicesLoopData.Rate, false);
+		UE_LOG(TerrainPointsCreator, Log, TEXT("Point indices data is up to date, skip writing."));
+		return;
+	}
+
 	if (!WritePointIndicesLoopData.HasInitialized) {
 		WritePointIndicesLoopData.HasInitialized = true;
-		ofs.open(*FullPath, std::ios::out | std::ios::trunc);
+		OpenDataWriter(FullPath);
 		ProgressTarget = Points.Num();
 	}
-	else {
-		ofs.open(*FullPath, std::ios::out | std::ios::app);
-	}
 
-	if (!ofs || !ofs.is_open()) {
+	if (!DataWriter.IsOpen()) {
 		UE_LOG(TerrainPointsCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
 		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
 		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointIndicesLoopData.Rate, false);
 		return;
 	}
-	WritePointIndices(ofs);
+	WritePointIndices(DataWriter);
 }
 
-void ATerrainPointsCreator::WritePointIndices(std::ofstream& ofs)
+void ATerrainPointsCreator::WritePointIndices(FBufferedDataWriter& Writer)
 {
 	int32 Count = 0;
 	TArray<int32> Indices = { 0 };
@@ -464,41 +742,43 @@ void ATerrainPointsCreator::WritePointIndices(std::ofstream& ofs)
 		Indices[0] = i;
 		FlowControlUtility::SaveLoopData(this, WritePointIndicesLoopData, Count, Indices, WorkflowDelegate, SaveLoopFlag);
 		if (SaveLoopFlag) {
-			ofs.close();
 			return;
 		}
-		WritePointIndicesLine(ofs, i);
+		WritePointIndicesLine(Writer, i);
 		ProgressCurrent = WritePointIndicesLoopData.Count;
 		Count++;
 	}
-	ofs.close();
 	FTimerHandle TimerHandle;
+	if (!Writer.Close()) {
+		UE_LOG(TerrainPointsCreator, Warning, TEXT("Write points indices failed!"));
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointIndicesLoopData.Rate, false);
+		return;
+	}
+
 	WorkflowState = Enum_TerrainPointsCreatorWorkflowState::WriteParams;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, WritePointIndicesLoopData.Rate, false);
 	UE_LOG(TerrainPointsCreator, Log, TEXT("Write points indices done."));
 }
 
-void ATerrainPointsCreator::WritePointIndicesLine(std::ofstream& ofs, int32 Index)
+void ATerrainPointsCreator::WritePointIndicesLine(FBufferedDataWriter& Writer, int32 Index)
 {
-	FIntPoint key = Points[Index].AxialCoord;
-	WriteIndicesKey(ofs, key);
-	WritePipeDelimiter(ofs);
-	WriteIndicesValue(ofs, Index);
-	WriteLineEnd(ofs);
+	WriteIndicesKey(Writer, Points[Index].AxialCoord);
+	WritePipeDelimiter(Writer);
+	WriteIndicesValue(Writer, Index);
+	WriteLineEnd(Writer);
 }
 
-void ATerrainPointsCreator::WriteIndicesKey(std::ofstream& ofs, const FIntPoint& key)
+void ATerrainPointsCreator::WriteIndicesKey(FBufferedDataWriter& Writer, const FIntPoint& key)
 {
-	FString Str = FString::FromInt(key.X);
-	Str.Append(*CommaDelim);
-	Str.Append(FString::FromInt(key.Y));
-	ofs << TCHAR_TO_ANSI(*Str);
+	Writer.WriteInt(key.X);
+	WriteCommaDelimiter(Writer);
+	Writer.WriteInt(key.Y);
 }
 
-void ATerrainPointsCreator::WriteIndicesValue(std::ofstream& ofs, int32 Index)
+void ATerrainPointsCreator::WriteIndicesValue(FBufferedDataWriter& Writer, int32 Index)
 {
-	FString Str = FString::FromInt(Index);
-	ofs << TCHAR_TO_ANSI(*Str);
+	Writer.WriteInt(Index);
 }
 
 void ATerrainPointsCreator::WriteParamsToFile()
@@ -509,39 +789,42 @@ void ATerrainPointsCreator::WriteParamsToFile()
 	CreateFilePath(ParamsDataPath, FullPath);
 
 	FTimerHandle TimerHandle;
-	std::ofstream ofs;
-	ofs.open(*FullPath, std::ios::out | std::ios::trunc);
 	ProgressTarget = 1;
-
-	if (!ofs || !ofs.is_open()) {
+	if (!OpenDataWriter(FullPath, false)) {
 		UE_LOG(TerrainPointsCreator, Warning, TEXT("Open file %s failed!"), *FullPath);
 		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
 		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 		return;
 	}
 
-	WriteParams(ofs);
+	WriteParams(DataWriter);
 }
 
-void ATerrainPointsCreator::WriteParams(std::ofstream& ofs)
+void ATerrainPointsCreator::WriteParams(FBufferedDataWriter& Writer)
 {
-	WriteParamsContent(ofs);
+	WriteParamsContent(Writer);
 	ProgressCurrent = 1;
-	ofs.close();
+
 	FTimerHandle TimerHandle;
+	if (!Writer.Close()) {
+		UE_LOG(TerrainPointsCreator, Warning, TEXT("Write params failed!"));
+		WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Error;
+		GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
+		return;
+	}
+
 	WorkflowState = Enum_TerrainPointsCreatorWorkflowState::Done;
 	GetWorldTimerManager().SetTimer(TimerHandle, WorkflowDelegate, DefaultTimerRate, false);
 	UE_LOG(TerrainPointsCreator, Log, TEXT("Write params done."));
 }
 
-void ATerrainPointsCreator::WriteParamsContent(std::ofstream& ofs)
+void ATerrainPointsCreator::WriteParamsContent(FBufferedDataWriter& Writer)
 {
-	FString Str = FString::FromInt(GridRange);
-	ofs << TCHAR_TO_ANSI(*Str);
-	WritePipeDelimiter(ofs);
-	Str = FString::FromInt(NeighborRange);
-	ofs << TCHAR_TO_ANSI(*Str);
-	WriteLineEnd(ofs);
+	Writer.WriteInt(GridRange);
+	WritePipeDelimiter(Writer);
+	Writer.WriteInt(NeighborRange);
+	WriteLineEnd(Writer);
+	WriteParamsHash(Writer, CalParamsHash(GridRange, NeighborRange));
 }
 
 void ATerrainPointsCreator::GetProgress(float& Out_Progress)
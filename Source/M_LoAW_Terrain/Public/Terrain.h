@@ -15,11 +15,13 @@ UENUM(BlueprintType)
 enum class Enum_TerrainWorkflowState : uint8
 {
 	InitWorkflow,
+	LoadBakedData,
 	CreateVerticesAndUVs,
 	CreateTriangles,
 	CalNormalsInit,
 	CalNormalsAcc,
 	NormalizeNormals,
+	SaveBakedData,
 	DrawLandMesh,
 	CreateWater,
 	CreateTree,
@@ -145,6 +147,9 @@ private:
 	float TileNumRowRatio = 1.0;
 	float TileNumColumnRatio = 1.0;
 
+	//Hash of all params affecting baked data
+	uint32 BakeParamsHash = 0;
+
 protected:
 	//Mesh
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly)
@@ -276,6 +281,14 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Timer")
 	float UpdateMousePosTimerRate = 0.01f;
 
+	//Bake BP, vertices, normals, vertex colors and tree values are cached in Saved directory
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Bake")
+	bool bUseBakedData = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Bake")
+	FString BakedDataRelPath = FString(TEXT("Terrain/"));
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Bake")
+	FString BakedDataFileName = FString(TEXT("TerrainBake.bin"));
+
 	//Loop data BP
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	FStructLoopData CreateVerticesLoopData;
@@ -381,6 +394,16 @@ private:
 	UFUNCTION()
 	void CreateTerrainFlow();
 
+	//Baked data
+	void InitBakeParamsHash();
+	FString GetBakedDataPath();
+	void LoadBakedData();
+	bool LoadBakedDataFromFile();
+	bool ParseBakedData(const uint8* Data, int64 Size);
+	void RebuildUVsAndTriangles();
+	void SaveBakedData();
+	bool SaveBakedDataToFile();
+
 	//progress
 	void ResetProgress();
 
@@ -465,6 +488,11 @@ public:
 		return TerrainHeight;
 	}
 
+	//Hash of noise, tile and terrain params, valid after InitWorkflow
+	M_LOAW_TERRAIN_API FORCEINLINE uint32 GetBakeParamsHash() {
+		return BakeParamsHash;
+	}
+
 	M_LOAW_TERRAIN_API FORCEINLINE float GetTileAltitudeMultiplier() {
 		return TileAltitudeMultiplier;
 	}
@@ -4,9 +4,9 @@
 
 
 #include "TerrainStructDefine.h"
-#include "Quad.h"
 #include "CoreMinimal.h"
 #include "DataCreator.h"
+#include "GridTopology.h"
 #include "TerrainPointsCreator.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(TerrainPointsCreator, Log, All);
@@ -15,6 +15,7 @@ UENUM(BlueprintType)
 enum class Enum_TerrainPointsCreatorWorkflowState : uint8
 {
 	InitWorkflow,
+	StreamCreate,
 	SpiralCreateCenter,
 	SpiralCreateNeighbors,
 	WritePoints,
@@ -25,7 +26,8 @@ enum class Enum_TerrainPointsCreatorWorkflowState : uint8
 	Error
 };
 
-#define TERRAIN_POINTS_RING_START_DIRECTION_INDEX	0
+//Version of generated data, bump when creator output changes for the same params
+#define TERRAIN_POINTS_DATA_VERSION	1
 
 UCLASS(MinimalAPI)
 class ATerrainPointsCreator : public ADataCreator
@@ -44,12 +46,14 @@ private:
 	TArray<FStructTerrainPointData> Points;
 	TMap<FIntPoint, int32> PointIndices;
 
-	//Flag for spiral ring
-	bool RingInitFlag = false;
+	//Incremental write, points data and neighbor radii below NeighborBegin are kept
+	bool bWritePointsData = true;
+	int32 NeighborBegin = 1;
 
-	int32 NeighborStep = 4;
-
-	Quad TmpQuad;
+	//Streaming state, one writer per output file, [Points, PointIndices,] N(NeighborBegin)..N(NeighborRange)
+	TArray<TUniquePtr<FBufferedDataWriter>> StreamWriters;
+	int32 StreamNeighborWriterBegin = 0;
+	int32 StreamBufferSize = 1 << 20;
 
 protected:
 	//Params
@@ -58,12 +62,18 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Params", meta = (ClampMin = "1"))
 	int32 NeighborRange = 3;
 
+	//Stream, write every point as soon as it is generated instead of building all points in memory
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Stream")
+	bool bStreamCreate = true;
+
 	//Timer
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Timer")
 	float DefaultTimerRate = 0.01f;
 
 	//Loop BP
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
+	struct FStructLoopData StreamCreateLoopData;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	struct FStructLoopData SpiralCreateCenterLoopData;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Loop")
 	struct FStructLoopData SpiralCreateNeighborsLoopData;
@@ -94,9 +104,20 @@ protected:
 	FString PointIndicesDataFileName = FString(TEXT("PointIndices.data"));
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
 	FString ParamsDataFileName = FString(TEXT("Params.data"));
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Custom|Path")
+	FString CheckpointFileName = FString(TEXT("Checkpoint.data"));
 
 
 private:
+	//Dataset cache
+	uint32 CalParamsHash(int32 InGridRange, int32 InNeighborRange);
+	bool IsCachedDataValid();
+	void InitIncrementalWrite();
+
+	//Checkpoint of stream create, the only stage whose state fits in loop indices and file sizes
+	bool InitResume();
+	void SaveStreamCheckpoint();
+
 	//Timer delegate
 	void BindDelegate();
 
@@ -110,41 +131,47 @@ private:
 
 	void ResetProgress();
 
+	//Stream create, points and neighbor lines are derived from the spiral position only
+	void StreamCreate();
+	bool OpenStreamWriters(bool bResume);
+	bool CloseStreamWriters();
+	void WriteStreamPoint(const FIntPoint& Coord, int32 Index);
+	void WriteStreamNeighborLine(FBufferedDataWriter& Writer, const FIntPoint& Center, int32 Radius);
+
 	//Create center
 	void SpiralCreateCenter();
 	void InitGridCenter();
-	void AddRingPointAndIndex();
-	void FindNeighborPointOfRing(int32 DirIndex);
+	void AddRingPoint(const FIntPoint& AxialCoord);
 
 	//Create neighbors
 	void SpiralCreateNeighbors();
 	void AddPointNeighbor(int32 PointIndex, int32 Radius);
-	void SetPointNeighbor(int32 PointIndex, int32 Radius, int32 DirIndex);
+	void SetPointNeighbor(int32 PointIndex, int32 Radius, const FIntPoint& Coord);
 
 	//Write points data to file
 	void WritePointsToFile();
-	void WritePoints(std::ofstream& ofs);
-	void WritePointLine(std::ofstream& ofs, int32 Index);
-	void WriteAxialCoord(std::ofstream& ofs, const FStructTerrainPointData& Data);
+	void WritePoints(FBufferedDataWriter& Writer);
+	void WritePointLine(FBufferedDataWriter& Writer, int32 Index);
+	void WriteAxialCoord(FBufferedDataWriter& Writer, const FStructTerrainPointData& Data);
 
 	//Write neighbors to file
 	void WriteNeighborsToFile();
 	int32 CalNeighborsWeight(int32 Range);
 	void CreateNeighborPath(FString& NeighborPath, int32 Radius);
-	bool WriteNeighbors(std::ofstream& ofs, int32 Radius);
-	void WriteNeighborLine(std::ofstream& ofs, int32 Index, int32 Radius);
+	bool WriteNeighbors(FBufferedDataWriter& Writer, int32 Radius);
+	void WriteNeighborLine(FBufferedDataWriter& Writer, int32 Index, int32 Radius);
 
 	//Write point indices data to file
 	void WritePointIndicesToFile();
-	void WritePointIndices(std::ofstream& ofs);
-	void WritePointIndicesLine(std::ofstream& ofs, int32 Index);
-	void WriteIndicesKey(std::ofstream& ofs, const FIntPoint& key);
-	void WriteIndicesValue(std::ofstream& ofs, int32 Index);
+	void WritePointIndices(FBufferedDataWriter& Writer);
+	void WritePointIndicesLine(FBufferedDataWriter& Writer, int32 Index);
+	void WriteIndicesKey(FBufferedDataWriter& Writer, const FIntPoint& key);
+	void WriteIndicesValue(FBufferedDataWriter& Writer, int32 Index);
 
 	//Write info data to file
 	void WriteParamsToFile();
-	void WriteParams(std::ofstream& ofs);
-	void WriteParamsContent(std::ofstream& ofs);
+	void WriteParams(FBufferedDataWriter& Writer);
+	void WriteParamsContent(FBufferedDataWriter& Writer);
 	
 public:
 	UFUNCTION(BlueprintCallable)